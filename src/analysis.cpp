@@ -0,0 +1,245 @@
+
+#include "analysis.hpp"
+#include "board.hpp"
+#include "move.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+enum {
+  // Positions handed out but not yet written, per thread
+  JOBS_PER_THREAD = 4,
+};
+
+// Board trusts its FEN, so the position is checked before building one. The
+// reason it can't be analysed, or empty if it can
+static std::string fen_error(const std::vector<std::string> &fields) noexcept {
+  // squares[rank][file], with rank 0 the eighth rank as in the FEN
+  char squares[8][8] = {};
+  int ranks = 1, files = 0, white_kings = 0, black_kings = 0;
+  for (const char chr : fields[0]) {
+    if (chr == '/') {
+      if (files != 8)
+        return "no position";
+      ranks++;
+      files = 0;
+    } else if ('1' <= chr && chr <= '8') {
+      files += chr - '0';
+    } else if (std::string("PNBRQKpnbrqk").find(chr) != std::string::npos) {
+      if (ranks <= 8 && files < 8)
+        squares[ranks - 1][files] = chr;
+      files++;
+      white_kings += chr == 'K';
+      black_kings += chr == 'k';
+    } else {
+      return "no position";
+    }
+    if (files > 8)
+      return "no position";
+  }
+  if (ranks != 8 || files != 8 || white_kings != 1 || black_kings != 1)
+    return "no position";
+  if (fields[1] != "w" && fields[1] != "b")
+    return "no position";
+  if (fields[2].find_first_not_of("KQkq-") != std::string::npos)
+    return "no position";
+  if (fields[3] != "-" && !(fields[3].size() == 2 && 'a' <= fields[3][0]
+    && fields[3][0] <= 'h' && (fields[3][1] == '3' || fields[3][1] == '6')))
+    return "no position";
+
+  const auto piece_at = [&](const int rank, const int file) {
+    return (0 <= rank && rank < 8 && 0 <= file && file < 8) ? squares[rank][file] : '\0';
+  };
+  for (int file = 0; file < 8; ++file) {
+    if (std::tolower(squares[0][file]) == 'p' || std::tolower(squares[7][file]) == 'p')
+      return "pawn on back rank";
+  }
+
+  const bool white = fields[1] == "w";
+  if (fields[3] != "-") {
+    // The pawn that just moved two squares is in front of the square, with
+    // the square it left empty behind
+    const int file = fields[3][0] - 'a', rank = '8' - fields[3][1];
+    const int forward = white ? 1 : -1;
+    if (fields[3][1] != (white ? '6' : '3') || squares[rank][file] != '\0'
+      || squares[rank - forward][file] != '\0' || squares[rank + forward][file] != (white ? 'p' : 'P'))
+      return "en passant square without a pawn to capture";
+  }
+
+  const struct { char right, king, rook; int rank, rook_file; } castles[] = {
+    {'K', 'K', 'R', 7, 7}, {'Q', 'K', 'R', 7, 0}, {'k', 'k', 'r', 0, 7}, {'q', 'k', 'r', 0, 0},
+  };
+  for (const auto &castle : castles) {
+    if (fields[2].find(castle.right) != std::string::npos && (squares[castle.rank][4] != castle.king
+      || squares[castle.rank][castle.rook_file] != castle.rook))
+      return "castling rights without king and rook";
+  }
+
+  // The side to move may not be able to take the other king
+  int king_rank = 0, king_file = 0;
+  for (int rank = 0; rank < 8; ++rank) {
+    for (int file = 0; file < 8; ++file) {
+      if (squares[rank][file] == (white ? 'k' : 'K')) {
+        king_rank = rank;
+        king_file = file;
+      }
+    }
+  }
+  const auto attacker = [&](const char piece) { return white ? (char)std::toupper(piece) : piece; };
+  // White pawns attack towards rank 0
+  const int pawn_rank = king_rank + (white ? 1 : -1);
+  if (piece_at(pawn_rank, king_file - 1) == attacker('p') || piece_at(pawn_rank, king_file + 1) == attacker('p'))
+    return "side not to move in check";
+  const int leaps[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+  const int steps[8][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}, {1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+  for (int dir = 0; dir < 8; ++dir) {
+    if (piece_at(king_rank + leaps[dir][0], king_file + leaps[dir][1]) == attacker('n')
+      || piece_at(king_rank + steps[dir][0], king_file + steps[dir][1]) == attacker('k'))
+      return "side not to move in check";
+    // The first four steps are rook lines, the rest bishop lines
+    const char slider = attacker(dir < 4 ? 'r' : 'b');
+    for (int dist = 1; dist < 8; ++dist) {
+      const char piece = piece_at(king_rank + dist * steps[dir][0], king_file + dist * steps[dir][1]);
+      if (piece == slider || piece == attacker('q'))
+        return "side not to move in check";
+      if (piece != '\0')
+        break;
+    }
+  }
+  return "";
+}
+
+std::string fen_from_epd(const std::string &line, std::string &error) noexcept {
+  // Anything after a ';' is perft counts or EPD opcodes
+  std::istringstream stream(line.substr(0, line.find(';')));
+  std::vector<std::string> fields;
+  std::string field;
+  while (fields.size() < 6 && stream >> field)
+    fields.push_back(field);
+  error = (fields.size() < 4) ? "no position" : fen_error(fields);
+  if (!error.empty())
+    return "";
+  // EPD has no move counters, and its opcodes follow the fourth field
+  const bool has_counters = fields.size() == 6
+    && fields[4].find_first_not_of("0123456789") == std::string::npos
+    && fields[5].find_first_not_of("0123456789") == std::string::npos;
+  return fields[0] + " " + fields[1] + " " + fields[2] + " " + fields[3] + " "
+    + (has_counters ? fields[4] + " " + fields[5] : "0 1");
+}
+
+std::string fen_from_epd(const std::string &line) noexcept {
+  std::string error;
+  return fen_from_epd(line, error);
+}
+
+std::string analysis_json(const size_t line_number, const std::string &fen,
+  const search_info_t &info) noexcept {
+  std::ostringstream out;
+  out << "{\"line\":" << line_number << ",\"fen\":\"" << fen << "\",\"depth\":" << info.depth
+    << ",\"nodes\":" << info.nodes << ",\"lines\":[";
+  for (size_t idx = 0; idx < info.lines.size(); ++idx) {
+    const pv_line_t &line = info.lines[idx];
+    out << (idx > 0 ? "," : "") << "{";
+    if (is_mate_score(line.score))
+      out << "\"mate\":" << mate_moves(line.score);
+    else
+      out << "\"cp\":" << line.score;
+    out << ",\"pv\":[";
+    for (size_t ply = 0; ply < line.pv.size(); ++ply)
+      out << (ply > 0 ? "," : "") << "\"" << uci_from_move(line.pv[ply]) << "\"";
+    out << "]}";
+  }
+  out << "]}";
+  return out.str();
+}
+
+size_t analyse_epd(std::istream &in, std::ostream &out, const analysis_options_t &options) noexcept {
+  struct job_t {
+    size_t sequence, line_number;
+    std::string fen;
+  };
+  const unsigned num_threads = std::max(options.threads, 1u);
+  search_limits_t limits = options.limits;
+  limits.time_ms = 0;
+  limits.clock = time_control_t();
+  limits.ponder = false;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<job_t> jobs;
+  // Finished output waiting for earlier positions, by sequence number
+  std::map<size_t, std::string> finished;
+  size_t next_sequence = 0, next_write = 0, analysed = 0;
+  bool done_reading = false;
+
+  // Called with the lock held
+  const auto publish = [&](const size_t sequence, std::string text) {
+    finished.emplace(sequence, std::move(text));
+    while (!finished.empty() && finished.begin()->first == next_write) {
+      out << finished.begin()->second << '\n';
+      finished.erase(finished.begin());
+      next_write++;
+    }
+    cv.notify_all();
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned id = 0; id < num_threads; ++id) {
+    workers.emplace_back([&] {
+      TranspositionTable tt(options.hash_mb, false);
+      Searcher searcher(tt);
+      std::unique_lock<std::mutex> lock(mutex);
+      while (true) {
+        cv.wait(lock, [&] { return !jobs.empty() || done_reading; });
+        if (jobs.empty())
+          return;
+        const job_t job = std::move(jobs.front());
+        jobs.pop_front();
+        lock.unlock();
+        TRACE_SCOPE(PHASE, "analyse", job.line_number);
+        // Entries from earlier positions are still correct, so the table is
+        // kept rather than cleared for every position
+        const search_info_t info = searcher.run(Board(job.fen), limits);
+        std::string text = analysis_json(job.line_number, job.fen, info);
+        lock.lock();
+        analysed++;
+        publish(job.sequence, std::move(text));
+      }
+    });
+  }
+
+  std::string line;
+  size_t line_number = 0;
+  while (std::getline(in, line)) {
+    line_number++;
+    const size_t start = line.find_first_not_of(" \t\r");
+    if (start == std::string::npos || line[start] == '#')
+      continue;
+    std::string error;
+    const std::string fen = fen_from_epd(line, error);
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] { return next_sequence - next_write < JOBS_PER_THREAD * num_threads; });
+    if (fen.empty())
+      publish(next_sequence++, "{\"line\":" + std::to_string(line_number) + ",\"error\":\"" + error + "\"}");
+    else
+      jobs.push_back({next_sequence++, line_number, fen});
+    cv.notify_all();
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    done_reading = true;
+  }
+  cv.notify_all();
+  for (std::thread &worker : workers)
+    worker.join();
+  out.flush();
+  return analysed;
+}
@@ -0,0 +1,54 @@
+
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <string>
+
+#include "defs.hpp"
+#include "search.hpp"
+#include "tt.hpp"
+
+/*
+BATCH ANALYSIS:
+Positions are read one per line, analysed to a fixed depth or node count, and
+written out as one JSON object per line, in input order.
+- Lines may be EPD (the four position fields, then opcodes), full FENs, or
+  FENs followed by "; ..." as in tests/perft.txt. Blank lines and lines
+  starting with '#' are skipped but still numbered.
+- Positions are spread over a pool of single-threaded searchers, each with its
+  own transposition table, since independent positions scale much better than
+  threads sharing one search. Results are written as soon as every earlier
+  position is done, and at most a few positions per thread are in flight, so
+  inputs of any length stream through in constant memory.
+- Output looks like
+  {"line":1,"fen":"...","depth":8,"nodes":12345,"lines":[{"cp":25,"pv":["e2e4","e7e5"]},...]}
+  with "mate" (in moves, negative when mated) in place of "cp" for mates, or
+  {"line":1,"error":"..."} for lines without a position or with one that
+  can't be played from: pawns on the back ranks, an en passant square with no
+  pawn to capture, castling rights without the king and rook at home, or the
+  side not to move in check.
+*/
+
+struct analysis_options_t {
+  // Depth and node limits apply per position; the clock is ignored
+  search_limits_t limits;
+  unsigned threads = 1;
+  size_t hash_mb = TranspositionTable::DEFAULT_SIZE_MB;
+};
+
+// The FEN in an EPD, FEN or perft line, or empty if there is none or it isn't
+// a legal position, with the reason in error
+std::string fen_from_epd(const std::string &line, std::string &error) noexcept;
+std::string fen_from_epd(const std::string &line) noexcept;
+
+// One line of output for the position on input line line_number
+std::string analysis_json(const size_t line_number, const std::string &fen,
+  const search_info_t &info) noexcept;
+
+// Analyses every position in in, returning the number of positions analysed
+size_t analyse_epd(std::istream &in, std::ostream &out, const analysis_options_t &options) noexcept;
+
+#endif /* end of include guard: ANALYSIS_H */
@@ -5,17 +5,6 @@
 #include <cstdio>
 #include <cstdlib>
 
-#if defined(INFO)
-#define INFO(...) \
-  do { \
-    printf("[INFO] "); \
-    printf(__VA_ARGS__); \
-    printf(" (%s:%s:%d)\n", __FILE__, __func__, __LINE__); \
-  } while (0)
-#else
-#define INFO(...) do {} while (0)
-#endif
-
 #define WARN(s) \
   printf("[WARN] %s (%s:%s:%d)\n", \
   s, __FILE__, __func__, __LINE__)
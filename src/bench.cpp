@@ -0,0 +1,184 @@
+
+#include "bench.hpp"
+#include "board.hpp"
+#include "move.hpp"
+#include "square.hpp"
+#include "timeit.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <random>
+#include <utility>
+
+namespace bench {
+
+std::vector<std::string> sample_corpus(const size_t games, const uint64_t seed,
+  const size_t max_plies, const size_t sample_every) noexcept {
+  std::vector<std::string> result;
+  std::mt19937_64 rng(seed);
+  for (size_t game = 0; game < games; ++game) {
+    Board board;
+    for (size_t ply = 0; ply < max_plies && !board.is_drawn(); ++ply) {
+      const std::vector<move_t> moves = board.legal_moves();
+      if (moves.empty())
+        break;
+      // Positions whose en passant square the parser would elide are left
+      // out, so that the corpus round-trips and parses without warnings
+      const bool round_trips = board.m_en_passant == INVALID_SQUARE
+        || board.keeps_en_passant(board.m_en_passant);
+      if (ply % std::max<size_t>(sample_every, 1) == 0 && round_trips)
+        result.push_back(board.fen());
+      board.make_move(moves[rng() % moves.size()]);
+    }
+  }
+  return result;
+}
+
+summary_t summarise(const std::string &name, const size_t operations,
+  std::vector<double> samples) noexcept {
+  summary_t result;
+  result.name = name;
+  result.operations = operations;
+  result.samples = samples.size();
+  if (samples.empty())
+    return result;
+  const auto median_of = [](std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    const size_t mid = values.size() / 2;
+    return (values.size() % 2 == 1) ? values[mid] : (values[mid - 1] + values[mid]) / 2;
+  };
+  const double median = median_of(samples);
+  std::vector<double> deviations;
+  for (const double sample : samples)
+    deviations.push_back(std::abs(sample - median));
+  const double mad = median_of(deviations);
+  // With no spread at all, only exact matches are kept
+  samples.erase(std::remove_if(samples.begin(), samples.end(), [&](const double sample) {
+    return std::abs(sample - median) > OUTLIER_MADS * mad;
+  }), samples.end());
+
+  result.kept = samples.size();
+  result.median_ns = median_of(samples);
+  result.min_ns = *std::min_element(samples.begin(), samples.end());
+  double sum = 0, sum_squares = 0;
+  for (const double sample : samples) {
+    sum += sample;
+    sum_squares += sample * sample;
+  }
+  result.mean_ns = sum / samples.size();
+  result.stddev_ns = std::sqrt(std::max(0.0, sum_squares / samples.size() - result.mean_ns * result.mean_ns));
+  return result;
+}
+
+std::vector<summary_t> run(const std::vector<std::string> &corpus, const size_t samples) noexcept {
+  std::vector<Board> boards;
+  for (const std::string &fen : corpus)
+    boards.emplace_back(fen);
+
+  std::vector<summary_t> results;
+  // body() runs operations operations once
+  const auto measure = [&](const std::string &name, const size_t operations, const auto &body) {
+    if (operations == 0) {
+      results.push_back(summarise(name, 0, {}));
+      return;
+    }
+    // Enough repetitions of the corpus for each sample to be timed accurately
+    const size_t warmup_ns = std::max<size_t>(timeit(body), 1);
+    const size_t repetitions = std::max<size_t>(1, MIN_SAMPLE_NS / warmup_ns);
+    std::vector<double> times;
+    for (size_t sample = 0; sample < samples; ++sample) {
+      const size_t ns = timeit([&] {
+        for (size_t rep = 0; rep < repetitions; ++rep)
+          body();
+      });
+      times.push_back((double)ns / (repetitions * operations));
+    }
+    results.push_back(summarise(name, operations * repetitions, times));
+  };
+
+  measure("fen parse", corpus.size(), [&] {
+    for (const std::string &fen : corpus) {
+      const Board board(fen);
+      do_not_optimize(board.m_hash);
+    }
+  });
+  measure("fen serialise", boards.size(), [&] {
+    for (const Board &board : boards) {
+      const std::string fen = board.fen();
+      do_not_optimize(fen);
+    }
+  });
+  measure("hash", boards.size(), [&] {
+    for (const Board &board : boards)
+      do_not_optimize(board.hash());
+  });
+  measure("compute_hash", boards.size(), [&] {
+    for (const Board &board : boards)
+      do_not_optimize(board.compute_hash());
+  });
+
+  // Legal moves of every position, by type
+  const std::vector<std::pair<std::string, std::vector<MoveFlag>>> move_types = {
+    {"quiet", {QUIET_MOVE}},
+    {"double pawn", {DOUBLE_PAWN_MOVE}},
+    {"castle", {SHORT_CASTLE_MOVE, LONG_CASTLE_MOVE}},
+    {"capture", {CAPTURE_MOVE}},
+    {"en passant", {EN_PASSANT_MOVE}},
+    {"promotion", {PROMOTE_KNIGHT_MOVE, PROMOTE_BISHOP_MOVE, PROMOTE_ROOK_MOVE, PROMOTE_QUEEN_MOVE}},
+    {"promotion capture", {PROMOTE_KNIGHT_CAPTURE_MOVE, PROMOTE_BISHOP_CAPTURE_MOVE,
+      PROMOTE_ROOK_CAPTURE_MOVE, PROMOTE_QUEEN_CAPTURE_MOVE}},
+  };
+  for (const auto &[type_name, flags] : move_types) {
+    std::vector<std::pair<size_t, move_t>> moves;
+    for (size_t idx = 0; idx < boards.size(); ++idx) {
+      for (const move_t move : boards[idx].legal_moves())
+        if (std::find(flags.begin(), flags.end(), move_flag(move)) != flags.end())
+          moves.emplace_back(idx, move);
+    }
+    measure("make+unmake " + type_name, moves.size(), [&] {
+      for (const auto &[idx, move] : moves) {
+        Board &board = boards[idx];
+        do_not_optimize(board.make_move(move));
+        board.unmake_move();
+      }
+    });
+  }
+
+  measure("pseudo_moves (uncached)", boards.size(), [&] {
+    for (const Board &board : boards)
+      do_not_optimize(board.generate_moves());
+  });
+  measure("legal_moves", boards.size(), [&] {
+    for (const Board &board : boards)
+      do_not_optimize(board.legal_moves());
+  });
+  measure("square_attacked", boards.size() * 128, [&] {
+    for (const Board &board : boards) {
+      for (square_t square = 0; square < 64; ++square) {
+        do_not_optimize(board.square_attacked(get_square_120(square), WHITE));
+        do_not_optimize(board.square_attacked(get_square_120(square), BLACK));
+      }
+    }
+  });
+  return results;
+}
+
+void report(std::ostream &out, const std::vector<summary_t> &results) noexcept {
+  out << std::left << std::setw(32) << "benchmark" << std::right << std::setw(12) << "ops/sample"
+    << std::setw(10) << "kept" << std::setw(12) << "median ns" << std::setw(12) << "mean ns"
+    << std::setw(10) << "stddev" << std::setw(10) << "min ns" << "\n" << std::fixed << std::setprecision(2);
+  for (const summary_t &result : results) {
+    out << std::left << std::setw(32) << result.name << std::right << std::setw(12) << result.operations;
+    if (result.samples == 0) {
+      out << std::setw(10) << "-" << "  (no positions)\n";
+      continue;
+    }
+    out << std::setw(10) << (std::to_string(result.kept) + "/" + std::to_string(result.samples))
+      << std::setw(12) << result.median_ns << std::setw(12) << result.mean_ns
+      << std::setw(10) << result.stddev_ns << std::setw(10) << result.min_ns << "\n";
+  }
+  out << std::defaultfloat;
+}
+
+} // namespace bench
@@ -0,0 +1,57 @@
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "defs.hpp"
+
+/*
+MICROBENCHMARKS:
+Times each board primitive over a corpus of positions sampled from random
+games, so that a perft regression can be traced to the primitive behind it.
+- Every benchmark is warmed up once, then timed over the whole corpus in
+  samples of at least MIN_SAMPLE_NS, repeating the corpus as needed.
+- Samples further than OUTLIER_MADS median absolute deviations from the
+  median (e.g. preempted by another process) are dropped before the mean and
+  standard deviation are taken.
+- Results are passed through do_not_optimize (timeit.hpp), so the compiler
+  cannot drop the calls being measured.
+*/
+
+namespace bench {
+
+enum {
+  MIN_SAMPLE_NS = 2000000,
+  OUTLIER_MADS = 3,
+};
+
+struct summary_t {
+  std::string name;
+  size_t operations = 0; // Per sample
+  size_t samples = 0, kept = 0;
+  // Per operation
+  double median_ns = 0, mean_ns = 0, stddev_ns = 0, min_ns = 0;
+};
+
+// Positions every sample_every plies of games random games of up to
+// max_plies plies, the same ones for the same seed. Positions whose FEN would
+// not parse back to the same position are skipped.
+std::vector<std::string> sample_corpus(const size_t games, const uint64_t seed,
+  const size_t max_plies = 160, const size_t sample_every = 4) noexcept;
+
+// The statistics of the samples (in ns per operation) left after dropping outliers
+summary_t summarise(const std::string &name, const size_t operations,
+  std::vector<double> samples) noexcept;
+
+std::vector<summary_t> run(const std::vector<std::string> &corpus, const size_t samples) noexcept;
+
+void report(std::ostream &out, const std::vector<summary_t> &results) noexcept;
+
+} // namespace bench
+
+#endif /* end of include guard: BENCH_H */
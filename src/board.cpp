@@ -3,9 +3,14 @@
 #include "piece.hpp"
 #include "hash.hpp"
 #include "move.hpp"
+#include "eval.hpp"
+#include "material.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
 
 #include <algorithm>
 #include <iostream>
+#include <initializer_list>
 #include <iomanip>
 #include <string>
 #include <sstream>
@@ -97,9 +102,7 @@ Board::Board(const std::string &fen) noexcept {
     ASSERT_IF(m_next_move_colour == WHITE, row == RANK_6);
     ASSERT_IF(m_next_move_colour == BLACK, row == RANK_3);
     m_en_passant = get_square_120_rc(row, col);
-    const piece_t my_pawn = (m_next_move_colour == WHITE) ? WHITE_PAWN : BLACK_PAWN;
-    if (m_pieces[m_en_passant - 1] != my_pawn
-      && m_pieces[m_en_passant + 1] != my_pawn) {
+    if (!keeps_en_passant(m_en_passant)) {
       WARN("Elided en passant square");
       m_en_passant = INVALID_SQUARE;
     }
@@ -130,13 +133,18 @@ Board::Board(const std::string &fen) noexcept {
   m_half_move = 2 * full_move + m_next_move_colour;
   ASSERT_MSG(next_chr == end_ptr, "FEN string too long");
 
+  m_psq = compute_psq();
+  m_phase = compute_phase();
+  m_material_key = compute_material_key();
+  refresh_accumulator();
+  m_pawn_hash = compute_pawn_hash();
   m_hash = compute_hash();
   validate_board();
 }
 
 void Board::validate_board() const noexcept {
 #if defined(DEBUG)
-  static std::array<unsigned, 16> piece_count;
+  std::array<unsigned, 16> piece_count;
   piece_count.fill(0);
   for (unsigned sq = 0; sq < 120; ++sq) {
     ASSERT_MSG(valid_piece(m_pieces[sq]) || m_pieces[sq] == INVALID_PIECE,
@@ -180,6 +188,18 @@ void Board::validate_board() const noexcept {
     "En passant square (%s - %u) not on row 6 on white's turn",
       string_from_square(m_en_passant).c_str(), m_en_passant);
 
+  ASSERT_MSG(m_pawn_hash == compute_pawn_hash(), "Pawn hash out of date");
+  ASSERT_MSG(m_psq == compute_psq(), "Piece-square sums out of date");
+  ASSERT_MSG(m_phase == compute_phase(), "Game phase (%d) out of date", m_phase);
+  ASSERT_MSG(m_material_key == compute_material_key(),
+    "Material key (%u) out of date", m_material_key);
+  if (nnue::enabled()) {
+    nnue::accumulator_t accumulator;
+    nnue::refresh(accumulator, *this, WHITE);
+    nnue::refresh(accumulator, *this, BLACK);
+    ASSERT_MSG(accumulator.values == m_accumulator.values, "Accumulator out of date");
+  }
+
   // Assert other king is not in check
   const piece_t king_piece = (m_next_move_colour == BLACK) ? WHITE_KING : BLACK_KING;
   const square_t king_square = m_positions[king_piece][0];
@@ -257,23 +277,74 @@ std::string Board::fen() const noexcept {
 hash_t Board::compute_hash() const noexcept {
   validate_board();
   hash_t res = 0;
-  for (unsigned sq = 0; sq < 120; ++sq) {
+  for (square_t sq64 = 0; sq64 < 64; ++sq64) {
+    const square_t sq = get_square_120(sq64);
     const piece_t piece = m_pieces[sq];
     ASSERT_MSG(0 <= piece && piece < 16,
       "Out of range piece (%u) in square", piece);
-    ASSERT_MSG(valid_piece(piece) || piece_hash[sq][piece] == 0,
+    ASSERT_MSG(valid_piece(piece) || piece_hash(sq, piece) == 0,
       "Invalid piece (%u) had non-zero hash (%llu)",
-        piece, piece_hash[sq][piece]);
-    res ^= piece_hash[sq][piece];
+        piece, (unsigned long long)piece_hash(sq, piece));
+    res ^= piece_hash(sq, piece);
   }
-  res ^= castle_hash[m_castle_state];
-  ASSERT_MSG(enpas_hash[INVALID_SQUARE] == 0,
-    "Invalid square had non-zero hash (%llu)", enpas_hash[INVALID_SQUARE]);
-  res ^= enpas_hash[m_en_passant];
+  res ^= castle_hash(m_castle_state);
+  res ^= enpas_hash(m_en_passant);
   res ^= (m_next_move_colour * side_hash);
   return res;
 }
 
+hash_t Board::compute_pawn_hash() const noexcept {
+  hash_t res = 0;
+  for (const piece_t pawn : {WHITE_PAWN, BLACK_PAWN})
+    for (unsigned idx = 0; idx < m_num_pieces[pawn]; ++idx)
+      res ^= piece_hash(m_positions[pawn][idx], pawn);
+  return res;
+}
+
+psq_t Board::compute_psq() const noexcept {
+  psq_t result;
+  for (square_t sq = 0; sq < 120; ++sq)
+    if (valid_square(sq) && m_pieces[sq] != INVALID_PIECE)
+      result += psq_table[m_pieces[sq]][sq];
+  return result;
+}
+
+int Board::compute_phase() const noexcept {
+  int result = 0;
+  for (piece_t piece = 0; piece < 16; ++piece)
+    result += phase_weight[piece] * m_num_pieces[piece];
+  return result;
+}
+
+uint32_t Board::compute_material_key() const noexcept {
+  return ::compute_material_key(m_num_pieces);
+}
+
+bool Board::is_repetition(const unsigned times) const noexcept {
+  // History entries hold the hash before their move, and a position can only
+  // repeat with the same side to move, at least four plies later
+  const size_t window = std::min<size_t>(m_fifty_move, m_history.size());
+  unsigned count = 0;
+  for (size_t back = 4; back <= window; back += 2)
+    if (m_history[m_history.size() - back].hash == m_hash && ++count >= times)
+      return true;
+  return false;
+}
+
+bool Board::is_drawn() const noexcept {
+  if (m_half_move > 1000 || m_fifty_move > MAX_FIFTY_MOVE || is_repetition(2))
+    return true;
+  material_entry_t scratch;
+  return probe_material(*this, scratch).drawn;
+}
+
+void Board::refresh_accumulator() noexcept {
+  if (!nnue::enabled())
+    return;
+  nnue::refresh(m_accumulator, *this, WHITE);
+  nnue::refresh(m_accumulator, *this, BLACK);
+}
+
 std::string Board::to_string() const noexcept {
   validate_board();
   std::stringstream result;
@@ -359,21 +430,179 @@ bool Board::square_attacked(const square_t sq, const bool side) const noexcept {
   return false;
 }
 
+static inline uint64_t square_bit(const square_t sq) noexcept {
+  return 1ull << get_square_64(sq);
+}
+
+// Attacker values for least_valuable_attacker: the king is only picked when
+// nothing else attacks the square
+enum { NO_ATTACKER = 1 << 20, KING_ATTACKER = NO_ATTACKER - 1 };
+
+square_t Board::least_valuable_attacker(const square_t sq, const bool side,
+  const uint64_t removed) const noexcept {
+  ASSERT(valid_square(sq));
+  const piece_t pawn_piece = (side == WHITE) ? WHITE_PAWN : BLACK_PAWN,
+                knight_piece = (side == WHITE) ? WHITE_KNIGHT : BLACK_KNIGHT;
+  const auto &present = [&](const square_t cur_square, const piece_t piece) {
+    return m_pieces[cur_square] == piece && !(removed & square_bit(cur_square));
+  };
+
+  // Pawns
+  const auto &pawn_offsets = {(side == WHITE) ? -9 : 9, (side == WHITE) ? -11 : 11};
+  for (const int offset : pawn_offsets)
+    if (present(sq + offset, pawn_piece))
+      return sq + offset;
+
+  // Knights
+  for (const int offset : {-21, -19, -12, -8, 8, 12, 19, 21})
+    if (present(sq + offset, knight_piece))
+      return sq + offset;
+
+  // Sliders and the king: the first piece along each ray, looking through
+  // removed squares so x-ray attackers show up once the front piece is gone
+  square_t best_square = INVALID_SQUARE;
+  int best_value = NO_ATTACKER;
+  for (const int offset : {-11, -10, -9, -1, 1, 9, 10, 11}) {
+    const bool diagonal = (offset == -11 || offset == -9 || offset == 9 || offset == 11);
+    square_t cur_square = sq + offset;
+    while (valid_square(cur_square) && (m_pieces[cur_square] == INVALID_PIECE
+      || (removed & square_bit(cur_square))))
+      cur_square += offset;
+    if (!valid_square(cur_square))
+      continue;
+    const piece_t piece = m_pieces[cur_square];
+    if (get_side(piece) != side)
+      continue;
+    int value = NO_ATTACKER;
+    if (is_king(piece) && cur_square == sq + offset)
+      value = KING_ATTACKER;
+    else if (diagonal ? is_diag(piece) : is_ortho(piece))
+      value = piece_value[piece];
+    if (value < best_value) {
+      best_value = value;
+      best_square = cur_square;
+    }
+  }
+  return best_square;
+}
+
+int Board::see(const move_t move) const noexcept {
+  if (move_castled(move))
+    return 0;
+  const square_t from = move_from(move), to = move_to(move);
+  const piece_t attacker = m_pieces[from];
+  uint64_t removed = square_bit(from);
+
+  // gain[d] is the balance for the side making the d-th capture, if the
+  // sequence stopped there
+  std::array<int, 32> gain;
+  int on_square = piece_value[attacker];
+  if (move_flag(move) == EN_PASSANT_MOVE) {
+    gain[0] = piece_value[WHITE_PAWN];
+    removed |= square_bit((get_side(attacker) == WHITE) ? to - 10 : to + 10);
+  } else {
+    gain[0] = (m_pieces[to] == INVALID_PIECE) ? 0 : piece_value[m_pieces[to]];
+  }
+  if (move_promoted(move)) {
+    on_square = piece_value[promoted_piece(move)];
+    gain[0] += on_square - piece_value[WHITE_PAWN];
+  }
+
+  bool side = !get_side(attacker);
+  int depth = 0;
+  while (depth + 1 < (int)gain.size()) {
+    const square_t sq = least_valuable_attacker(to, side, removed);
+    if (sq == INVALID_SQUARE)
+      break;
+    removed |= square_bit(sq);
+    // The king may only recapture if that does not walk into check
+    if (is_king(m_pieces[sq]) && least_valuable_attacker(to, !side, removed) != INVALID_SQUARE)
+      break;
+    depth++;
+    gain[depth] = on_square - gain[depth - 1];
+    on_square = piece_value[m_pieces[sq]];
+    side = !side;
+  }
+  // Either side may stop capturing when continuing would lose material
+  while (depth > 0) {
+    gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+    depth--;
+  }
+  return gain[0];
+}
+
+bool Board::see_ge(const move_t move, const int threshold) const noexcept {
+  if (move_castled(move))
+    return threshold <= 0;
+  const square_t from = move_from(move), to = move_to(move);
+  const piece_t attacker = m_pieces[from];
+  uint64_t removed = square_bit(from);
+
+  int victim = 0, on_square = piece_value[attacker];
+  if (move_flag(move) == EN_PASSANT_MOVE) {
+    victim = piece_value[WHITE_PAWN];
+    removed |= square_bit((get_side(attacker) == WHITE) ? to - 10 : to + 10);
+  } else if (m_pieces[to] != INVALID_PIECE) {
+    victim = piece_value[m_pieces[to]];
+  }
+  if (move_promoted(move)) {
+    on_square = piece_value[promoted_piece(move)];
+    victim += on_square - piece_value[WHITE_PAWN];
+  }
+
+  // swap tracks how far the side that just captured is above the threshold,
+  // and the loop exits as soon as the side to recapture cannot change the
+  // outcome, so most calls never walk the full sequence
+  int swap = victim - threshold;
+  if (swap < 0)
+    return false;
+  swap = on_square - swap;
+  if (swap <= 0)
+    return true;
+
+  bool side = !get_side(attacker);
+  bool result = true;
+  while (true) {
+    const square_t sq = least_valuable_attacker(to, side, removed);
+    if (sq == INVALID_SQUARE)
+      break;
+    result = !result;
+    removed |= square_bit(sq);
+    if (is_king(m_pieces[sq]))
+      return (least_valuable_attacker(to, !side, removed) != INVALID_SQUARE) ? !result : result;
+    swap = piece_value[m_pieces[sq]] - swap;
+    if (swap < (int)result)
+      break;
+    side = !side;
+  }
+  return result;
+}
+
 bool Board::king_in_check() const noexcept {
   const piece_t king_piece = (m_next_move_colour == WHITE) ? WHITE_KING : BLACK_KING;
   return square_attacked(m_positions[king_piece][0], !m_next_move_colour);
 }
 
-std::vector<move_t> Board::pseudo_moves(const int _side) const noexcept {
+std::vector<move_t> Board::pseudo_moves(const int side) const noexcept {
   const auto &it = m_move_cache.find(m_hash);
-  if (it != m_move_cache.end())
+  STAT_INC(STAT_MOVE_CACHE_PROBES);
+  if (it != m_move_cache.end()) {
+    STAT_INC(STAT_MOVE_CACHE_HITS);
     return it->second;
+  }
+
+  if (m_half_move > 1000 || m_fifty_move > MAX_FIFTY_MOVE)
+    return {}; // 50 (75) move rule
+  // Copied rather than moved into the cache, so that entries do not keep the
+  // generator's reserved capacity
+  const std::vector<move_t> result = generate_moves(side);
+  return m_move_cache[m_hash] = result;
+}
 
+std::vector<move_t> Board::generate_moves(const int _side) const noexcept {
   validate_board();
 
   std::vector<move_t> result;
-  if (m_half_move > 1000 || m_fifty_move > 75)
-    return result; // 50 (75) move rule
   result.reserve(MAX_POSITION_MOVES);
 
   const int side = (_side != INVALID_SIDE) ? _side : m_next_move_colour;
@@ -399,13 +628,13 @@ std::vector<move_t> Board::pseudo_moves(const int _side) const noexcept {
       while (valid_square(cur_square) && m_pieces[cur_square] == INVALID_PIECE) {
         // printf("Quiet move from %s to %s\n",
         //   string_from_square(start).c_str(), string_from_square(cur_square).c_str());
-        result.push_back(quiet_move(start, cur_square, queen_piece));
+        result.push_back(quiet_move(start, cur_square));
         cur_square += offset;
       }
       if (valid_square(cur_square) && opposite_colours(queen_piece, m_pieces[cur_square]) && !is_king(m_pieces[cur_square])) {
         // printf("Capture move from %s to %s\n",
         //  string_from_square(start).c_str(), string_from_square(cur_square).c_str());
-        result.push_back(capture_move(start, cur_square, queen_piece, m_pieces[cur_square]));
+        result.push_back(capture_move(start, cur_square));
       }
     }
   }
@@ -418,13 +647,13 @@ std::vector<move_t> Board::pseudo_moves(const int _side) const noexcept {
       while (valid_square(cur_square) && m_pieces[cur_square] == INVALID_PIECE) {
         // printf("Quiet move from %s to %s\n",
         //   string_from_square(start).c_str(), string_from_square(cur_square).c_str());
-        result.push_back(quiet_move(start, cur_square, rook_piece));
+        result.push_back(quiet_move(start, cur_square));
         cur_square += offset;
       }
       if (valid_square(cur_square) && opposite_colours(rook_piece, m_pieces[cur_square]) && !is_king(m_pieces[cur_square])) {
         // printf("Capture move from %s to %s\n",
         //  string_from_square(start).c_str(), string_from_square(cur_square).c_str());
-        result.push_back(capture_move(start, cur_square, rook_piece, m_pieces[cur_square]));
+        result.push_back(capture_move(start, cur_square));
       }
     }
   }
@@ -437,13 +666,13 @@ std::vector<move_t> Board::pseudo_moves(const int _side) const noexcept {
       while (valid_square(cur_square) && m_pieces[cur_square] == INVALID_PIECE) {
         // printf("Quiet move from %s to %s\n",
         //   string_from_square(start).c_str(), string_from_square(cur_square).c_str());
-        result.push_back(quiet_move(start, cur_square, bishop_piece));
+        result.push_back(quiet_move(start, cur_square));
         cur_square += offset;
       }
       if (valid_square(cur_square) && opposite_colours(bishop_piece, m_pieces[cur_square]) && !is_king(m_pieces[cur_square])) {
         // printf("Capture move from %s to %s\n",
         //  string_from_square(start).c_str(), string_from_square(cur_square).c_str());
-        result.push_back(capture_move(start, cur_square, bishop_piece, m_pieces[cur_square]));
+        result.push_back(capture_move(start, cur_square));
       }
     }
   }
@@ -454,9 +683,9 @@ std::vector<move_t> Board::pseudo_moves(const int _side) const noexcept {
     for (const int offset : {-21, -19, -12, -8, 8, 12, 19, 21}) {
       const square_t cur_square = start + offset;
       if (valid_square(cur_square) && m_pieces[cur_square] == INVALID_PIECE)
-        result.push_back(quiet_move(start, cur_square, knight_piece));
+        result.push_back(quiet_move(start, cur_square));
       else if (valid_square(cur_square) && opposite_colours(knight_piece, m_pieces[cur_square]) && !is_king(m_pieces[cur_square]))
-        result.push_back(capture_move(start, cur_square, knight_piece, m_pieces[cur_square]));
+        result.push_back(capture_move(start, cur_square));
     }
   }
 
@@ -466,11 +695,11 @@ std::vector<move_t> Board::pseudo_moves(const int _side) const noexcept {
     // Double pawn moves
     if (side == WHITE && get_square_row(start) == RANK_2
       && m_pieces[start + 10] == INVALID_PIECE && m_pieces[start + 20] == INVALID_PIECE) {
-      result.push_back(double_move(start, start + 20, pawn_piece));
+      result.push_back(double_move(start, start + 20));
     }
     if (side == BLACK && get_square_row(start) == RANK_7
       && m_pieces[start - 10] == INVALID_PIECE && m_pieces[start - 20] == INVALID_PIECE) {
-      result.push_back(double_move(start, start - 20, pawn_piece));
+      result.push_back(double_move(start, start - 20));
     }
 
     // Single pawn moves
@@ -479,10 +708,10 @@ std::vector<move_t> Board::pseudo_moves(const int _side) const noexcept {
     if (valid_square(cur_square) && m_pieces[cur_square] == INVALID_PIECE) {
       if (get_square_row(cur_square) == RANK_1 || get_square_row(cur_square) == RANK_8) {
         for (const piece_t promote_piece : promote_pieces) {
-          result.push_back(promote_move(start, cur_square, pawn_piece, promote_piece));
+          result.push_back(promote_move(start, cur_square, promote_piece));
         }
       } else {
-        result.push_back(quiet_move(start, start + offset, pawn_piece));
+        result.push_back(quiet_move(start, start + offset));
       }
     }
 
@@ -493,10 +722,10 @@ std::vector<move_t> Board::pseudo_moves(const int _side) const noexcept {
       && opposite_colours(pawn_piece, m_pieces[capture1]) && !is_king(m_pieces[capture1])) {
       if (get_square_row(capture1) == RANK_1 || get_square_row(capture1) == RANK_8) {
         for (const piece_t promote_piece : promote_pieces) {
-          result.push_back(promote_capture_move(start, capture1, pawn_piece, promote_piece, m_pieces[capture1]));
+          result.push_back(promote_capture_move(start, capture1, promote_piece));
         }
       } else {
-        result.push_back(capture_move(start, capture1, pawn_piece, m_pieces[capture1]));
+        result.push_back(capture_move(start, capture1));
       }
     }
     if (valid_square(capture2)
@@ -504,20 +733,20 @@ std::vector<move_t> Board::pseudo_moves(const int _side) const noexcept {
       && opposite_colours(pawn_piece, m_pieces[capture2]) && !is_king(m_pieces[capture2])) {
       if (get_square_row(capture2) == RANK_1 || get_square_row(capture2) == RANK_8) {
         for (const piece_t promote_piece : promote_pieces) {
-          result.push_back(promote_capture_move(start, capture2, pawn_piece, promote_piece, m_pieces[capture2]));
+          result.push_back(promote_capture_move(start, capture2, promote_piece));
         }
       } else {
-        result.push_back(capture_move(start, capture2, pawn_piece, m_pieces[capture2]));
+        result.push_back(capture_move(start, capture2));
       }
     }
 
     // En-pass capture
     if (m_en_passant != INVALID_SQUARE) {
       if (capture1 == m_en_passant && m_pieces[capture1] == INVALID_PIECE) {
-        result.push_back(en_passant_move(start, m_en_passant, pawn_piece));
+        result.push_back(en_passant_move(start, m_en_passant));
       }
       if (capture2 == m_en_passant && m_pieces[capture2] == INVALID_PIECE) {
-        result.push_back(en_passant_move(start, m_en_passant, pawn_piece));
+        result.push_back(en_passant_move(start, m_en_passant));
       }
     }
   }
@@ -529,9 +758,9 @@ std::vector<move_t> Board::pseudo_moves(const int _side) const noexcept {
     const piece_t piece = m_pieces[cur_square];
     if (valid_square(cur_square)) {
       if (piece == INVALID_PIECE) {
-        result.push_back(quiet_move(start, cur_square, king_piece));
+        result.push_back(quiet_move(start, cur_square));
       } else if (opposite_colours(king_piece, piece) && !is_king(piece)) {
-        result.push_back(capture_move(start, cur_square, king_piece, piece));
+        result.push_back(capture_move(start, cur_square));
       }
     }
   }
@@ -543,11 +772,11 @@ std::vector<move_t> Board::pseudo_moves(const int _side) const noexcept {
     const bool f1_attacked = square_attacked(F1, BLACK);
     if (m_castle_state & WHITE_SHORT && !e1_attacked && !f1_attacked
       && m_pieces[F1] == INVALID_PIECE && m_pieces[G1] == INVALID_PIECE) {
-      result.push_back(castle_move(E1, G1, WHITE_KING, SHORT_CASTLE_MOVE));
+      result.push_back(castle_move(E1, G1, SHORT_CASTLE_MOVE));
     }
     if (m_castle_state & WHITE_LONG && !e1_attacked && !d1_attacked
       && m_pieces[D1] == INVALID_PIECE && m_pieces[C1] == INVALID_PIECE && m_pieces[B1] == INVALID_PIECE) {
-      result.push_back(castle_move(E1, C1, WHITE_KING, LONG_CASTLE_MOVE));
+      result.push_back(castle_move(E1, C1, LONG_CASTLE_MOVE));
     }
   } else if (side == BLACK) {
     const bool d8_attacked = square_attacked(D8, WHITE);
@@ -555,16 +784,185 @@ std::vector<move_t> Board::pseudo_moves(const int _side) const noexcept {
     const bool f8_attacked = square_attacked(F8, WHITE);
     if (m_castle_state & BLACK_SHORT && !e8_attacked && !f8_attacked
       && m_pieces[F8] == INVALID_PIECE && m_pieces[G8] == INVALID_PIECE) {
-      result.push_back(castle_move(E8, G8, BLACK_KING, SHORT_CASTLE_MOVE));
+      result.push_back(castle_move(E8, G8, SHORT_CASTLE_MOVE));
     }
     if (m_castle_state & BLACK_LONG && !e8_attacked && !d8_attacked
       && m_pieces[D8] == INVALID_PIECE && m_pieces[C8] == INVALID_PIECE && m_pieces[B8] == INVALID_PIECE) {
-      result.push_back(castle_move(E8, C8, BLACK_KING, LONG_CASTLE_MOVE));
+      result.push_back(castle_move(E8, C8, LONG_CASTLE_MOVE));
     }
   }
 
   ASSERT(result.size() <= MAX_POSITION_MOVES);
-  return m_move_cache[m_hash] = result;
+  STAT_HISTOGRAM(HIST_MOVES, result.size());
+  return result;
+}
+
+std::vector<move_t> Board::unmoves() const noexcept {
+  validate_board();
+  std::vector<move_t> result;
+  const int side = !m_next_move_colour;
+  const piece_t base = (side == WHITE) ? 0 : 8;
+
+  // Pieces other than pawns move the same way backwards, so they could have
+  // come from any empty square they reach now
+  const auto add_retractions = [&](const piece_t piece, const std::initializer_list<int> offsets,
+    const bool slides) {
+    for (unsigned idx = 0; idx < m_num_pieces[piece]; ++idx) {
+      const square_t to = m_positions[piece][idx];
+      for (const int offset : offsets) {
+        square_t from = to + offset;
+        while (valid_square(from) && m_pieces[from] == INVALID_PIECE) {
+          result.push_back(quiet_move(from, to));
+          if (!slides)
+            break;
+          from += offset;
+        }
+      }
+    }
+  };
+  add_retractions(base + WHITE_QUEEN, {-11, -10, -9, -1, 1, 9, 10, 11}, true);
+  add_retractions(base + WHITE_ROOK, {-10, -1, 1, 10}, true);
+  add_retractions(base + WHITE_BISHOP, {-11, -9, 9, 11}, true);
+  add_retractions(base + WHITE_KNIGHT, {-21, -19, -12, -8, 8, 12, 19, 21}, false);
+  add_retractions(base + WHITE_KING, {-11, -10, -9, -1, 1, 9, 10, 11}, false);
+
+  // Pawns step back, and twice from the fourth rank to their starting rank
+  const piece_t pawn_piece = base + WHITE_PAWN;
+  const int offset = (side == WHITE) ? -10 : 10;
+  const int start_rank = (side == WHITE) ? RANK_2 : RANK_7;
+  for (unsigned pawn_idx = 0; pawn_idx < m_num_pieces[pawn_piece]; ++pawn_idx) {
+    const square_t to = m_positions[pawn_piece][pawn_idx];
+    const square_t from = to + offset;
+    if (m_pieces[from] != INVALID_PIECE || get_square_row(to) == start_rank)
+      continue;
+    result.push_back(quiet_move(from, to));
+    if (get_square_row(from) == start_rank + ((side == WHITE) ? 1 : -1)
+      && m_pieces[from + offset] == INVALID_PIECE)
+      result.push_back(double_move(from + offset, to));
+  }
+  return result;
+}
+
+std::vector<move_t> Board::tactical_moves(const bool checks) const noexcept {
+  validate_board();
+
+  std::vector<move_t> result;
+  result.reserve(64);
+
+  const int side = m_next_move_colour;
+  const piece_t king_piece   = (side == WHITE) ? WHITE_KING   : BLACK_KING,
+                queen_piece  = (side == WHITE) ? WHITE_QUEEN  : BLACK_QUEEN,
+                rook_piece   = (side == WHITE) ? WHITE_ROOK   : BLACK_ROOK,
+                bishop_piece = (side == WHITE) ? WHITE_BISHOP : BLACK_BISHOP,
+                knight_piece = (side == WHITE) ? WHITE_KNIGHT : BLACK_KNIGHT,
+                pawn_piece   = (side == WHITE) ? WHITE_PAWN   : BLACK_PAWN;
+
+  // Squares from which each piece type would attack the enemy king
+  uint64_t diagonal_checks = 0, orthogonal_checks = 0, knight_checks = 0, pawn_checks = 0;
+  if (checks) {
+    const square_t enemy_king = m_positions[king_piece ^ 8u][0];
+    for (const int offset : {-11, -10, -9, -1, 1, 9, 10, 11}) {
+      const bool diagonal = (offset == -11 || offset == -9 || offset == 9 || offset == 11);
+      uint64_t &mask = diagonal ? diagonal_checks : orthogonal_checks;
+      for (square_t cur_square = enemy_king + offset;
+        valid_square(cur_square) && m_pieces[cur_square] == INVALID_PIECE; cur_square += offset)
+        mask |= square_bit(cur_square);
+    }
+    for (const int offset : {-21, -19, -12, -8, 8, 12, 19, 21})
+      if (valid_square(enemy_king + offset))
+        knight_checks |= square_bit(enemy_king + offset);
+    for (const int offset : {(side == WHITE) ? -9 : 9, (side == WHITE) ? -11 : 11})
+      if (valid_square(enemy_king + offset))
+        pawn_checks |= square_bit(enemy_king + offset);
+  }
+
+  const auto &add_capture = [&](const square_t start, const square_t cur_square, const piece_t piece) {
+    const piece_t victim = m_pieces[cur_square];
+    if (valid_square(cur_square) && victim != INVALID_PIECE && opposite_colours(piece, victim) && !is_king(victim))
+      result.push_back(capture_move(start, cur_square));
+  };
+
+  // Sliders: captures at the end of each ray, checks along it
+  const auto &add_slider_moves = [&](const piece_t piece, const std::initializer_list<int> &offsets) {
+    const uint64_t check_mask = (is_diag(piece) ? diagonal_checks : 0)
+      | (is_ortho(piece) ? orthogonal_checks : 0);
+    for (unsigned idx = 0; idx < m_num_pieces[piece]; ++idx) {
+      const square_t start = m_positions[piece][idx];
+      for (const int offset : offsets) {
+        square_t cur_square = start + offset;
+        while (valid_square(cur_square) && m_pieces[cur_square] == INVALID_PIECE) {
+          if (check_mask & square_bit(cur_square))
+            result.push_back(quiet_move(start, cur_square));
+          cur_square += offset;
+        }
+        add_capture(start, cur_square, piece);
+      }
+    }
+  };
+  add_slider_moves(queen_piece, {-11, -10, -9, -1, 1, 9, 10, 11});
+  add_slider_moves(rook_piece, {-10, -1, 1, 10});
+  add_slider_moves(bishop_piece, {-11, -9, 9, 11});
+
+  // Knights
+  for (unsigned knight_idx = 0; knight_idx < m_num_pieces[knight_piece]; ++knight_idx) {
+    const square_t start = m_positions[knight_piece][knight_idx];
+    for (const int offset : {-21, -19, -12, -8, 8, 12, 19, 21}) {
+      const square_t cur_square = start + offset;
+      if (valid_square(cur_square) && m_pieces[cur_square] == INVALID_PIECE) {
+        if (knight_checks & square_bit(cur_square))
+          result.push_back(quiet_move(start, cur_square));
+      } else {
+        add_capture(start, cur_square, knight_piece);
+      }
+    }
+  }
+
+  // Pawns
+  const piece_t promote_pieces[4] = {
+    static_cast<piece_t>(queen_piece ^ 8u),  static_cast<piece_t>(rook_piece ^ 8u),
+    static_cast<piece_t>(bishop_piece ^ 8u), static_cast<piece_t>(knight_piece ^ 8u),
+  };
+  const int forward = (side == WHITE) ? 10 : -10;
+  for (unsigned pawn_idx = 0; pawn_idx < m_num_pieces[pawn_piece]; ++pawn_idx) {
+    const square_t start = m_positions[pawn_piece][pawn_idx];
+    const square_t cur_square = start + forward;
+    const bool promoting = get_square_row(cur_square) == RANK_1 || get_square_row(cur_square) == RANK_8;
+    if (m_pieces[cur_square] == INVALID_PIECE) {
+      if (promoting) {
+        for (const piece_t promote_piece : promote_pieces)
+          result.push_back(promote_move(start, cur_square, promote_piece));
+      } else if (pawn_checks & square_bit(cur_square)) {
+        result.push_back(quiet_move(start, cur_square));
+      } else if (checks && get_square_row(start) == ((side == WHITE) ? RANK_2 : RANK_7)
+        && m_pieces[cur_square + forward] == INVALID_PIECE
+        && (pawn_checks & square_bit(cur_square + forward))) {
+        result.push_back(double_move(start, cur_square + forward));
+      }
+    }
+
+    for (const square_t capture : {cur_square - 1, cur_square + 1}) {
+      const piece_t victim = m_pieces[capture];
+      if (valid_square(capture) && victim != INVALID_PIECE
+        && opposite_colours(pawn_piece, victim) && !is_king(victim)) {
+        if (promoting) {
+          for (const piece_t promote_piece : promote_pieces)
+            result.push_back(promote_capture_move(start, capture, promote_piece));
+        } else {
+          result.push_back(capture_move(start, capture));
+        }
+      } else if (m_en_passant != INVALID_SQUARE && capture == m_en_passant && victim == INVALID_PIECE) {
+        result.push_back(en_passant_move(start, m_en_passant));
+      }
+    }
+  }
+
+  // King captures only, it never gives check itself
+  const square_t king_square = m_positions[king_piece][0];
+  for (const int offset : {-11, -10, -9, -1, 1, 9, 10, 11})
+    add_capture(king_square, king_square + offset, king_piece);
+
+  STAT_HISTOGRAM(HIST_TACTICAL, result.size());
+  return result;
 }
 
 std::vector<move_t> Board::legal_moves() const noexcept {
@@ -579,7 +977,6 @@ std::vector<move_t> Board::legal_moves() const noexcept {
 }
 
 inline void Board::remove_piece(const square_t sq) noexcept {
-  INFO("Removing piece on square %s (%u)", string_from_square(sq).c_str(), sq);
   const piece_t piece = m_pieces[sq];
   ASSERT_MSG(valid_piece(piece), "Removing invalid piece (%u)!", piece);
   m_pieces[sq] = INVALID_PIECE;
@@ -589,33 +986,50 @@ inline void Board::remove_piece(const square_t sq) noexcept {
   ASSERT_MSG(this_idx != last_idx, "Removed piece (%d) not in piece_list", piece);
   m_num_pieces[piece]--;
   std::swap(*this_idx, *(last_idx - 1));
-  m_hash ^= piece_hash[sq][piece];
+  m_hash ^= piece_hash(sq, piece);
+  if (is_pawn(piece))
+    m_pawn_hash ^= piece_hash(sq, piece);
+  m_psq -= psq_table[piece][sq];
+  m_phase -= phase_weight[piece];
+  m_material_key -= material_weight[piece];
+  if (nnue::enabled())
+    nnue::remove_piece(m_accumulator, piece, sq, m_positions[WHITE_KING][0], m_positions[BLACK_KING][0]);
 }
 
 inline void Board::add_piece(const square_t sq, const piece_t piece) noexcept {
-  INFO("Adding piece (%c) to square %s", char_from_piece(piece), string_from_square(sq).c_str());
   ASSERT_MSG(valid_piece(piece), "Adding invalid piece!");
   ASSERT_MSG(m_pieces[sq] == INVALID_PIECE, "Adding piece would overwrite existing piece (%d)!", m_pieces[sq]);
   m_pieces[sq] = piece;
   m_positions[piece][m_num_pieces[piece]] = sq;
   m_num_pieces[piece]++;
-  m_hash ^= piece_hash[sq][piece];
+  m_hash ^= piece_hash(sq, piece);
+  if (is_pawn(piece))
+    m_pawn_hash ^= piece_hash(sq, piece);
+  m_psq += psq_table[piece][sq];
+  m_phase += phase_weight[piece];
+  m_material_key += material_weight[piece];
+  if (nnue::enabled())
+    nnue::add_piece(m_accumulator, piece, sq, m_positions[WHITE_KING][0], m_positions[BLACK_KING][0]);
 }
 
 inline void Board::set_castle_state(const castle_t state) noexcept {
-  INFO("Setting castle state to %u", state);
-  m_hash ^= castle_hash[m_castle_state] ^ castle_hash[state];
+  m_hash ^= castle_hash(m_castle_state) ^ castle_hash(state);
   m_castle_state = state;
 }
 
+bool Board::keeps_en_passant(const square_t sq) const noexcept {
+  const piece_t my_pawn = (m_next_move_colour == WHITE) ? WHITE_PAWN : BLACK_PAWN;
+  // Beside the pawn that moved two squares, one rank behind sq
+  const square_t pushed = (m_next_move_colour == WHITE) ? sq - 10 : sq + 10;
+  return m_pieces[pushed - 1] == my_pawn || m_pieces[pushed + 1] == my_pawn;
+}
+
 inline void Board::set_en_passant(const square_t sq) noexcept {
-  INFO("Setting en passant to %s", string_from_square(sq).c_str());
-  m_hash ^= enpas_hash[m_en_passant] ^ enpas_hash[sq];
+  m_hash ^= enpas_hash(m_en_passant) ^ enpas_hash(sq);
   m_en_passant = sq;
 }
 
 inline void Board::move_piece(const square_t from, const square_t to) noexcept {
-  INFO("Moving piece from %s to %s", string_from_square(from).c_str(), string_from_square(to).c_str());
   ASSERT_MSG(m_pieces[to] == INVALID_PIECE, "Attempted to move to occupied square");
   const piece_t piece = m_pieces[from];
   m_pieces[from] = INVALID_PIECE;
@@ -625,13 +1039,23 @@ inline void Board::move_piece(const square_t from, const square_t to) noexcept {
   const auto &this_idx = std::find(piece_list.begin(), last_idx, from);
   ASSERT_MSG(this_idx != last_idx, "Moved piece not in piece_list");
   *this_idx = to;
-  m_hash ^= piece_hash[from][piece] ^ piece_hash[to][piece];
+  m_hash ^= piece_hash(from, piece) ^ piece_hash(to, piece);
+  if (is_pawn(piece))
+    m_pawn_hash ^= piece_hash(from, piece) ^ piece_hash(to, piece);
+  m_psq -= psq_table[piece][from];
+  m_psq += psq_table[piece][to];
+  if (nnue::enabled()) {
+    // A king move changes every feature of its own side
+    if (is_king(piece))
+      nnue::refresh(m_accumulator, *this, get_side(piece));
+    else
+      nnue::move_piece(m_accumulator, piece, from, to, m_positions[WHITE_KING][0], m_positions[BLACK_KING][0]);
+  }
 }
 
 inline void Board::update_castling(const square_t sq, const piece_t moved) noexcept {
-  INFO("Updating castling with from = %s", string_from_square(sq).c_str());
   if (!is_castle(moved)) return;
-  m_hash ^= castle_hash[m_castle_state];
+  m_hash ^= castle_hash(m_castle_state);
   if (sq == E1 || sq == A1)
     m_castle_state &= ~WHITE_LONG;
   if (sq == E1 || sq == H1)
@@ -640,39 +1064,41 @@ inline void Board::update_castling(const square_t sq, const piece_t moved) noexc
     m_castle_state &= ~BLACK_LONG;
   if (sq == E8 || sq == H8)
     m_castle_state &= ~BLACK_SHORT;
-  m_hash ^= castle_hash[m_castle_state];
+  m_hash ^= castle_hash(m_castle_state);
 }
 
 inline void Board::switch_colours() noexcept {
-  INFO("Switching colours");
   m_next_move_colour ^= 1;
   m_hash ^= side_hash;
 }
 
 bool Board::make_move(const move_t move) noexcept {
-  INFO("=====================================================================================");
+  STAT_INC(STAT_MAKE_MOVES);
+  TRACE_SCOPE(DETAIL, "make_move", move);
   const MoveFlag flag = move_flag(move);
   const square_t from = move_from(move), to = move_to(move);
-  const piece_t moved = moved_piece(move);
-  INFO("%s", to_string().c_str());
-  INFO("Making move from %s to %s", string_from_square(from).c_str(), string_from_square(to).c_str());
-  INFO("Move flag is %s", string_from_flag(flag).c_str());
-  INFO("Promoted: %d, Captured: %d", move_promoted(move), move_captured(move));
+  const piece_t moved = m_pieces[from];
+  const piece_t captured = (flag == EN_PASSANT_MOVE) ? (piece_t)(moved ^ 8u) : m_pieces[to];
   const bool cur_side = m_next_move_colour, other_side = !cur_side;
 
   // Bookkeeping
   history_t entry;
   entry.move = move;
+  entry.moved = moved;
+  entry.captured = captured;
   entry.castle_state = m_castle_state;
   entry.en_passant = m_en_passant;
   entry.fifty_move = m_fifty_move;
   entry.hash = m_hash;
+  entry.pawn_hash = m_pawn_hash;
   m_history.push_back(entry);
   m_half_move++;
 
   if (move_promoted(move)) {
-    if (move_captured(move))
+    if (move_captured(move)) {
       remove_piece(to);
+      update_castling(to, captured);
+    }
     add_piece(to, promoted_piece(move));
     remove_piece(from);
     set_en_passant(INVALID_SQUARE);
@@ -707,49 +1133,44 @@ bool Board::make_move(const move_t move) noexcept {
       set_en_passant(INVALID_SQUARE);
     }
     if (flag == QUIET_MOVE) {
-      INFO("Handling quiet move");
       move_piece(from, to);
       update_castling(from, moved);
     } else if (flag == DOUBLE_PAWN_MOVE) {
-      INFO("Handling double pawn move");
       move_piece(from, to);
     } else if (flag == CAPTURE_MOVE) {
-      INFO("Handling capture move");
       remove_piece(to);
       move_piece(from, to);
       update_castling(from, moved);
+      // A rook captured on its starting square cannot castle either
+      update_castling(to, captured);
     } else if (flag == EN_PASSANT_MOVE) {
-      INFO("Handling en-passant move");
       remove_piece(enpas_square);
       move_piece(from, to);
     }
   }
-  if (move_captured(move) || is_pawn(moved_piece(move)))
+  if (move_captured(move) || is_pawn(moved))
     m_fifty_move = 0;
   else
     m_fifty_move++;
 
   switch_colours();
   const piece_t king_piece = (cur_side == WHITE) ? WHITE_KING : BLACK_KING;
-  INFO("Is %s king attacked by %s?", (cur_side == WHITE) ? "white" : "black", (other_side == WHITE) ? "white" : "black");
-  INFO("\n%s", to_string().c_str());
   const bool valid = !square_attacked(m_positions[king_piece][0], other_side);
-  INFO("%s king %s attacked", (cur_side == WHITE) ? "White" : "Black", valid ? "is not" : "is");
   if (valid) {
     validate_board();
-    INFO("=====================================================================================");
     return true;
   }
-  INFO("=====================================================================================");
   return false;
 }
 
 void Board::unmake_move() noexcept {
-  INFO("=====================================================================================");
+  STAT_INC(STAT_UNMAKE_MOVES);
   ASSERT_MSG(!m_history.empty(), "Trying to unmake move from starting position");
   const history_t entry = m_history.back();
   m_history.pop_back();
   const move_t move = entry.move;
+  ASSERT_MSG(move != NULL_MOVE, "Unmaking a null move with unmake_move");
+  TRACE_SCOPE(DETAIL, "unmake_move", move);
   const hash_t last_hash = entry.hash;
   set_castle_state(entry.castle_state);
   set_en_passant(entry.en_passant);
@@ -761,16 +1182,12 @@ void Board::unmake_move() noexcept {
 
   const MoveFlag flag = move_flag(move);
   const square_t from = move_from(move), to = move_to(move);
-  INFO("%s", to_string().c_str());
-  INFO("Unmaking move from %s to %s", string_from_square(from).c_str(), string_from_square(to).c_str());
-  INFO("Move flag is %s", string_from_flag(flag).c_str());
-  INFO("Promoted: %d, Captured: %d", move_promoted(move), move_captured(move));
 
   if (move_promoted(move)) {
     remove_piece(to);
-    add_piece(from, moved_piece(move));
+    add_piece(from, entry.moved);
     if (move_captured(move))
-      add_piece(to, captured_piece(move));
+      add_piece(to, entry.captured);
   } else if (move_castled(move)) {
     if (cur_side == WHITE) {
       if (flag == SHORT_CASTLE_MOVE) {
@@ -794,13 +1211,46 @@ void Board::unmake_move() noexcept {
     if (move_captured(move)) {
       const square_t en_pas_sq = (cur_side == WHITE) ? m_en_passant - 10 : m_en_passant + 10;
       const square_t captured_sq = (flag == CAPTURE_MOVE) ? to : en_pas_sq;
-      add_piece(captured_sq, captured_piece(move));
+      add_piece(captured_sq, entry.captured);
     }
   }
 
   ASSERT_MSG(m_hash == last_hash, "Hash did not match history entry's hash");
+  ASSERT_MSG(m_pawn_hash == entry.pawn_hash, "Pawn hash did not match history entry's pawn hash");
+  validate_board();
+}
+
+void Board::make_null_move() noexcept {
+  ASSERT_MSG(!king_in_check(), "Passing the turn while in check");
+  history_t entry;
+  entry.move = NULL_MOVE;
+  entry.moved = entry.captured = INVALID_PIECE;
+  entry.castle_state = m_castle_state;
+  entry.en_passant = m_en_passant;
+  entry.fifty_move = m_fifty_move;
+  entry.hash = m_hash;
+  entry.pawn_hash = m_pawn_hash;
+  m_history.push_back(entry);
+  m_half_move++;
+  set_en_passant(INVALID_SQUARE);
+  // Positions before a null move did not really occur on the way here, so
+  // repetition scans stop at it
+  m_fifty_move = 0;
+  switch_colours();
+  validate_board();
+}
+
+void Board::unmake_null_move() noexcept {
+  ASSERT_MSG(!m_history.empty() && m_history.back().move == NULL_MOVE,
+    "Last move was not a null move");
+  const history_t entry = m_history.back();
+  m_history.pop_back();
+  set_en_passant(entry.en_passant);
+  m_fifty_move = entry.fifty_move;
+  m_half_move--;
+  switch_colours();
+  ASSERT_MSG(m_hash == entry.hash, "Hash did not match history entry's hash");
   validate_board();
-  INFO("=====================================================================================");
 }
 
 void print_move_list(const std::vector<move_t> &move_list) {
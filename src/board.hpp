@@ -13,6 +13,8 @@
 #include "square.hpp"
 #include "castle_state.hpp"
 #include "hash.hpp"
+#include "psqt.hpp"
+#include "nnue.hpp"
 
 #define VARIANT_CHESS
 
@@ -24,13 +26,18 @@ enum { MAX_POSITION_MOVES = 4096 };
 #endif
 
 enum { WHITE = 0, BLACK = 1, INVALID_SIDE = -1 };
+// Plies since the last capture or pawn move past which the game is drawn
+enum { MAX_FIFTY_MOVE = 75 };
 
 struct history_t {
   move_t move;
+  // Read off the board by make_move, for unmake_move
+  piece_t moved, captured;
   castle_t castle_state;
   square_t en_passant;
   unsigned int fifty_move;
   hash_t hash;
+  hash_t pawn_hash;
 };
 
 struct Board {
@@ -43,10 +50,25 @@ struct Board {
   unsigned int m_fifty_move;
   unsigned int m_half_move;
   hash_t m_hash;
+  // Zobrist key of the pawns alone, for the pawn structure cache
+  hash_t m_pawn_hash;
+  // Material and piece-square sums, kept up to date by the piece helpers
+  psq_t m_psq;
+  int m_phase;
+  // Mixed radix piece counts, indexing the material table (see material.hpp)
+  uint32_t m_material_key;
+  // First layer of the network, only kept up to date while one is loaded
+  nnue::accumulator_t m_accumulator;
   std::vector<history_t> m_history;
   mutable std::map<hash_t, std::vector<move_t>> m_move_cache;
 
   hash_t compute_hash() const noexcept;
+  hash_t compute_pawn_hash() const noexcept;
+  psq_t compute_psq() const noexcept;
+  int compute_phase() const noexcept;
+  uint32_t compute_material_key() const noexcept;
+  // Recomputes the accumulator from scratch, e.g. after loading a network
+  void refresh_accumulator() noexcept;
   void validate_board() const noexcept;
 
 public:
@@ -59,6 +81,10 @@ public:
     ASSERT_MSG(m_hash == compute_hash(), "Hash invariant broken");
     return m_hash;
   }
+  inline hash_t pawn_hash() const noexcept {
+    ASSERT_MSG(m_pawn_hash == compute_pawn_hash(), "Pawn hash invariant broken");
+    return m_pawn_hash;
+  }
   inline piece_t piece_at(const square_t square) const noexcept {
     ASSERT(0 <= square && square < 120);
     return m_pieces[square];
@@ -73,10 +99,36 @@ public:
   std::string to_string() const noexcept;
 
   bool square_attacked(const square_t sq, const bool side) const noexcept;
+  // The square of side's least valuable piece attacking sq, treating the
+  // squares in removed (a 64-square bitmask) as empty. INVALID_SQUARE if none.
+  square_t least_valuable_attacker(const square_t sq, const bool side,
+    const uint64_t removed = 0) const noexcept;
+  // Static exchange evaluation: the material won by move, assuming both sides
+  // keep recapturing on its to-square with their least valuable attacker
+  int see(const move_t move) const noexcept;
+  bool see_ge(const move_t move, const int threshold) const noexcept;
   bool king_in_check() const noexcept;
   std::vector<move_t> pseudo_moves(const int side = INVALID_SIDE) const noexcept;
+  // Same as pseudo_moves, but bypasses m_move_cache and the move counters
+  std::vector<move_t> generate_moves(const int side = INVALID_SIDE) const noexcept;
+  // Captures (including en passant) and promotions only, for quiescence
+  // search. With checks, also quiet moves that give direct check.
+  std::vector<move_t> tactical_moves(const bool checks = false) const noexcept;
   std::vector<move_t> legal_moves() const noexcept;
-  inline bool is_drawn() const noexcept { return m_half_move > 1000 || m_fifty_move > 75; }
+  // Moves by the side that just moved that could have led here, each going
+  // from a square in a predecessor of this position. Only quiet moves and
+  // pawn pushes: no uncaptures, unpromotions, uncastling or en passant.
+  std::vector<move_t> unmoves() const noexcept;
+  // Whether the current position occurred at least times before. Only the
+  // moves since the last capture or pawn move are scanned.
+  bool is_repetition(const unsigned times) const noexcept;
+  // By the move counters, threefold repetition, or with too little material
+  // for either side to mate
+  bool is_drawn() const noexcept;
+  // Whether a FEN with en passant square sq keeps it when parsed, rather than
+  // eliding it with a warning: the side to move needs a pawn beside the pawn
+  // that moved two squares
+  bool keeps_en_passant(const square_t sq) const noexcept;
   inline void remove_piece(const square_t sq) noexcept;
   inline void add_piece(const square_t sq, const piece_t piece) noexcept;
   inline void set_castle_state(const castle_t state) noexcept;
@@ -86,6 +138,9 @@ public:
   inline void switch_colours() noexcept;
   bool make_move(const move_t move) noexcept;
   void unmake_move() noexcept;
+  // Passes the turn, for null-move pruning. Not allowed while in check.
+  void make_null_move() noexcept;
+  void unmake_null_move() noexcept;
 };
 
 std::ostream& operator<<(std::ostream &os, const Board& board) noexcept;
@@ -4,7 +4,7 @@
 
 using castle_t = uint8_t;
 using hash_t = uint64_t;
-using move_t = uint32_t;
+using move_t = uint16_t;
 using piece_t = uint8_t;
 
 #endif /* end of include guard: DEFS_H */
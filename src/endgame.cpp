@@ -0,0 +1,202 @@
+
+#include "endgame.hpp"
+#include "eval.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+static inline int distance_64(const int a, const int b) noexcept {
+  return std::max(std::abs(a / 8 - b / 8), std::abs(a % 8 - b % 8));
+}
+
+static inline int distance(const square_t a, const square_t b) noexcept {
+  return std::max(std::abs(get_square_row(a) - get_square_row(b)),
+    std::abs(get_square_col(a) - get_square_col(b)));
+}
+
+namespace kpk {
+
+/*
+KPK BITBASE:
+- one entry per side to move, white king, black king, and white pawn on files
+  a-d and ranks 2-7; the other files are mirrored onto these
+- positions are first marked invalid, won (the pawn queens safely), drawn
+  (stalemate, or the pawn falls) or unknown
+- unknown positions are then resolved from their successors until nothing
+  changes: white wins if some move wins, black draws if some move draws
+*/
+enum Result : uint8_t { INVALID = 0, UNKNOWN = 1, DRAW = 2, WIN = 4 };
+enum { NUM_POSITIONS = 2 * 64 * 64 * 24 };
+
+static inline int index(const bool white_to_move, const int wk, const int pawn,
+  const int bk) noexcept {
+  ASSERT(pawn % 8 < 4 && 1 <= pawn / 8 && pawn / 8 <= 6);
+  const int pawn_idx = (pawn % 8) * 6 + (pawn / 8 - 1);
+  return ((pawn_idx * 64 + wk) * 64 + bk) * 2 + white_to_move;
+}
+
+static inline bool pawn_attacks(const int pawn, const int sq) noexcept {
+  return sq / 8 == pawn / 8 + 1 && std::abs(sq % 8 - pawn % 8) == 1;
+}
+
+// Squares a king on sq can step to, 64-square form
+template <typename F>
+static inline void for_each_king_step(const int sq, F &&callback) noexcept {
+  for (int dr = -1; dr <= 1; ++dr) {
+    for (int dc = -1; dc <= 1; ++dc) {
+      const int row = sq / 8 + dr, col = sq % 8 + dc;
+      if ((dr != 0 || dc != 0) && 0 <= row && row < 8 && 0 <= col && col < 8)
+        callback(8 * row + col);
+    }
+  }
+}
+
+static Result initial(const bool white_to_move, const int wk, const int pawn,
+  const int bk) noexcept {
+  if (distance_64(wk, bk) <= 1 || wk == pawn || bk == pawn)
+    return INVALID;
+  if (white_to_move && pawn_attacks(pawn, bk))
+    return INVALID;
+
+  if (white_to_move) {
+    // The pawn promotes and the queen cannot be taken
+    const int queen = pawn + 8;
+    if (pawn / 8 == 6 && wk != queen && bk != queen
+      && (distance_64(bk, queen) > 1 || distance_64(wk, queen) == 1))
+      return WIN;
+    return UNKNOWN;
+  }
+
+  if (distance_64(bk, pawn) == 1 && distance_64(wk, pawn) > 1)
+    return DRAW;
+  bool stalemate = true;
+  for_each_king_step(bk, [&](const int to) {
+    if (distance_64(wk, to) > 1 && !pawn_attacks(pawn, to))
+      stalemate = false;
+  });
+  return stalemate ? DRAW : UNKNOWN;
+}
+
+static Result classify(const std::vector<uint8_t> &db, const bool white_to_move,
+  const int wk, const int pawn, const int bk) noexcept {
+  int result = INVALID;
+  if (white_to_move) {
+    for_each_king_step(wk, [&](const int to) {
+      result |= db[index(false, to, pawn, bk)];
+    });
+    // Promotions are covered by initial
+    const int push = pawn + 8;
+    if (pawn / 8 < 6 && push != wk && push != bk) {
+      result |= db[index(false, wk, push, bk)];
+      const int double_push = pawn + 16;
+      if (pawn / 8 == 1 && double_push != wk && double_push != bk)
+        result |= db[index(false, wk, double_push, bk)];
+    }
+    return (result & WIN) ? WIN : (result & UNKNOWN) ? UNKNOWN : DRAW;
+  }
+  for_each_king_step(bk, [&](const int to) {
+    result |= db[index(true, wk, pawn, to)];
+  });
+  return (result & DRAW) ? DRAW : (result & UNKNOWN) ? UNKNOWN : WIN;
+}
+
+static std::vector<uint8_t> build() noexcept {
+  std::vector<uint8_t> db(NUM_POSITIONS);
+  const auto for_each_position = [](auto &&callback) {
+    for (int file = 0; file < 4; ++file)
+      for (int rank = 1; rank <= 6; ++rank)
+        for (int wk = 0; wk < 64; ++wk)
+          for (int bk = 0; bk < 64; ++bk)
+            for (const bool white_to_move : {false, true})
+              callback(white_to_move, wk, 8 * rank + file, bk);
+  };
+  for_each_position([&](const bool stm, const int wk, const int pawn, const int bk) {
+    db[index(stm, wk, pawn, bk)] = initial(stm, wk, pawn, bk);
+  });
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for_each_position([&](const bool stm, const int wk, const int pawn, const int bk) {
+      uint8_t &entry = db[index(stm, wk, pawn, bk)];
+      if (entry != UNKNOWN)
+        return;
+      entry = classify(db, stm, wk, pawn, bk);
+      changed |= entry != UNKNOWN;
+    });
+  }
+  return db;
+}
+
+bool probe(const bool white_to_move, int wk, int pawn, int bk) noexcept {
+  static const std::vector<uint8_t> db = build();
+  ASSERT(1 <= pawn / 8 && pawn / 8 <= 6);
+  if (pawn % 8 >= 4) {
+    wk ^= 7;
+    pawn ^= 7;
+    bk ^= 7;
+  }
+  return db[index(white_to_move, wk, pawn, bk)] == WIN;
+}
+
+} // namespace kpk
+
+// Seen from side, so that side's pawns always move up
+static inline int relative_square_64(const square_t sq, const int side) noexcept {
+  const int row = get_square_row(sq), col = get_square_col(sq);
+  return 8 * ((side == WHITE) ? row : 7 - row) + col;
+}
+
+static inline int relative_rank(const square_t sq, const int side) noexcept {
+  return (side == WHITE) ? get_square_row(sq) : 7 - get_square_row(sq);
+}
+
+// 0 in the centre, 6 in a corner
+static inline int edge_distance_bonus(const square_t sq) noexcept {
+  const int row = get_square_row(sq), col = get_square_col(sq);
+  return std::max(3 - row, row - 4) + std::max(3 - col, col - 4);
+}
+
+int evaluate_endgame(const Board &board, const material_entry_t &entry) noexcept {
+  ASSERT(entry.endgame != NO_ENDGAME);
+  const int strong = entry.strong_side;
+  const piece_t base = (strong == WHITE) ? 0 : 8;
+  const square_t strong_king = board.m_positions[base + WHITE_KING][0];
+  const square_t weak_king = board.m_positions[(base ^ 8u) + WHITE_KING][0];
+  const int closeness = 7 - distance(strong_king, weak_king);
+
+  int score = 0;
+  switch (entry.endgame) {
+    case KPK_ENDGAME: {
+      const square_t pawn = board.m_positions[base + WHITE_PAWN][0];
+      const bool strong_to_move = board.m_next_move_colour == strong;
+      if (!kpk::probe(strong_to_move, relative_square_64(strong_king, strong),
+          relative_square_64(pawn, strong), relative_square_64(weak_king, strong)))
+        return 0;
+      score = KNOWN_WIN + piece_value[WHITE_PAWN] + 20 * relative_rank(pawn, strong);
+      break;
+    }
+    case KBNK_ENDGAME: {
+      // Mate is only possible in a corner of the bishop's colour
+      const square_t bishop = board.m_positions[base + WHITE_BISHOP][0];
+      const bool dark = (get_square_row(bishop) + get_square_col(bishop)) % 2 == 0;
+      const int corner_distance = dark
+        ? std::min(distance(weak_king, A1), distance(weak_king, H8))
+        : std::min(distance(weak_king, H1), distance(weak_king, A8));
+      score = KNOWN_WIN + 50 * (7 - corner_distance) + 10 * closeness;
+      break;
+    }
+    case KXK_ENDGAME: {
+      // Drive the bare king to the edge, and bring the other king along
+      score = KNOWN_WIN + 20 * edge_distance_bonus(weak_king) + 10 * closeness;
+      for (piece_t piece = base; piece < base + 8; ++piece)
+        score += piece_value[piece] * board.m_num_pieces[piece];
+      for (unsigned idx = 0; idx < board.m_num_pieces[base + WHITE_PAWN]; ++idx)
+        score += 10 * relative_rank(board.m_positions[base + WHITE_PAWN][idx], strong);
+      break;
+    }
+    default:
+      ASSERT_MSG(0, "Unknown endgame (%d)", entry.endgame);
+  }
+  return (board.m_next_move_colour == strong) ? score : -score;
+}
@@ -0,0 +1,28 @@
+
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include <cstdint>
+
+#include "defs.hpp"
+#include "board.hpp"
+#include "material.hpp"
+
+// Won endgames score at least KNOWN_WIN, well below any mate score, so the
+// search still prefers a real mate and converts towards it
+enum { KNOWN_WIN = 10000 };
+
+namespace kpk {
+
+// Whether white wins with the white king on wk, the white pawn on pawn and the
+// black king on bk, squares in 64-square form. The bitbase is built on first
+// use by retrograde analysis.
+bool probe(const bool white_to_move, const int wk, const int pawn, const int bk) noexcept;
+
+} // namespace kpk
+
+// Evaluation of the specialised endgame in entry, from the side to move's
+// point of view
+int evaluate_endgame(const Board &board, const material_entry_t &entry) noexcept;
+
+#endif /* end of include guard: ENDGAME_H */
@@ -0,0 +1,38 @@
+
+#include "eval.hpp"
+#include "endgame.hpp"
+#include "material.hpp"
+#include "nnue.hpp"
+
+#include <algorithm>
+
+int evaluate(const Board &board, PawnTable *pawns) noexcept {
+  // Known draws and endgames come first, the network does not know them
+  material_entry_t scratch;
+  const material_entry_t &material = probe_material(board, scratch);
+  if (material.drawn)
+    return 0;
+  if (material.endgame != NO_ENDGAME)
+    return evaluate_endgame(board, material);
+
+  if (nnue::enabled())
+    return nnue::evaluate(board);
+
+  // Material and piece-square terms are summed incrementally by the board, so
+  // this is a blend of the middlegame and endgame scores by the game phase.
+  // Promotions can push the phase past its starting value.
+  const int phase = std::min<int>(material.phase, MAX_PHASE);
+  psq_t psq = board.m_psq;
+  psq += material.imbalance;
+
+  pawn_entry_t uncached;
+  if (!pawns)
+    evaluate_pawns(board, uncached);
+  const pawn_entry_t &entry = pawns ? pawns->probe(board) : uncached;
+  psq += entry.score;
+  psq.mg += king_shelter(board, entry);
+
+  int score = (psq.mg * phase + psq.eg * (MAX_PHASE - phase)) / MAX_PHASE;
+  score = score * material.scale[(score > 0) ? WHITE : BLACK] / SCALE_NORMAL;
+  return (board.m_next_move_colour == WHITE) ? score : -score;
+}
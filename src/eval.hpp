@@ -0,0 +1,19 @@
+
+#ifndef EVAL_H
+#define EVAL_H
+
+#include "board.hpp"
+#include "pawns.hpp"
+#include "piece.hpp"
+
+// Nominal piece values in centipawns, indexed by piece
+constexpr int piece_value[16] = {
+  900, 500, 100, 0, 330, 320, 0, 0,
+  900, 500, 100, 0, 330, 320, 0, 0,
+};
+
+// Static evaluation in centipawns, from the side to move's point of view.
+// Pawn structure is cached in pawns if given, and recomputed otherwise.
+int evaluate(const Board &board, PawnTable *pawns = nullptr) noexcept;
+
+#endif /* end of include guard: EVAL_H */
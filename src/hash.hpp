@@ -11,11 +11,58 @@
 #include "square.hpp"
 
 hash_t random_hash() noexcept;
-extern hash_t piece_hash[120][16];
-extern hash_t castle_hash[16];
-extern hash_t enpas_hash[120];
-extern hash_t side_hash;
 
-void init_hash() noexcept;
+// Zobrist keys, generated at compile time by splitmix64 from a fixed seed, so
+// that hashes are the same in every build and process and can be stored
+namespace zobrist {
+
+constexpr hash_t SEED = 0x706C617963686573ULL;
+
+constexpr inline hash_t splitmix64(hash_t &state) noexcept {
+  hash_t result = (state += 0x9E3779B97F4A7C15ULL);
+  result = (result ^ (result >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  result = (result ^ (result >> 27)) * 0x94D049BB133111EBULL;
+  return result ^ (result >> 31);
+}
+
+struct keys_t {
+  // Zero for the unused piece values and INVALID_PIECE
+  hash_t piece[64][16] = {};
+  hash_t castle[16] = {};
+  hash_t en_passant[64] = {};
+  hash_t side = 0;
+};
+
+constexpr inline keys_t generate_keys() noexcept {
+  keys_t result;
+  hash_t state = SEED;
+  for (int sq = 0; sq < 64; ++sq)
+    for (piece_t piece = 0; piece < 16; ++piece)
+      if (valid_piece(piece))
+        result.piece[sq][piece] = splitmix64(state);
+  for (int castle = 0; castle < 16; ++castle)
+    result.castle[castle] = splitmix64(state);
+  for (int sq = 0; sq < 64; ++sq)
+    result.en_passant[sq] = splitmix64(state);
+  result.side = splitmix64(state);
+  return result;
+}
+
+inline constexpr keys_t keys = generate_keys();
+
+} // namespace zobrist
+
+constexpr inline hash_t piece_hash(const square_t sq, const piece_t piece) {
+  return zobrist::keys.piece[get_square_64(sq)][piece];
+}
+constexpr inline hash_t castle_hash(const castle_t state) {
+  ASSERT(state < 16);
+  return zobrist::keys.castle[state];
+}
+// Zero for INVALID_SQUARE, i.e. no en passant square
+constexpr inline hash_t enpas_hash(const square_t sq) {
+  return (sq == INVALID_SQUARE) ? 0 : zobrist::keys.en_passant[get_square_64(sq)];
+}
+constexpr hash_t side_hash = zobrist::keys.side;
 
 #endif /* end of include guard: HASH_H */
@@ -0,0 +1,282 @@
+
+#include "hwperf.hpp"
+#include "board.hpp"
+#include "move.hpp"
+#include "square.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+
+#ifdef __linux__
+  #include <linux/perf_event.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#endif
+
+namespace hwperf {
+
+enum {
+  // Plies in the line played out from each position for make and unmake
+  LINE_PLIES = 32,
+  // Calls per position and repetition for the cheaper primitives
+  INNER_CALLS = 16,
+};
+
+// Results are summed into here so that the measured calls are not optimised out
+static volatile uint64_t sink;
+
+const char *counter_name(const Counter counter) noexcept {
+  const char *const names[NUM_COUNTERS] = {"cycles", "instructions", "branch misses",
+    "L1D misses", "LLC misses"};
+  return names[counter];
+}
+
+static inline uint64_t clock_ns() noexcept {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+#ifdef __linux__
+static int open_counter(const Counter counter) noexcept {
+  perf_event_attr attr{};
+  attr.size = sizeof(attr);
+  attr.disabled = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  attr.type = PERF_TYPE_HARDWARE;
+  switch (counter) {
+    case CYCLES: attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+    case INSTRUCTIONS: attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+    case BRANCH_MISSES: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+    case L1D_MISSES:
+      attr.type = PERF_TYPE_HW_CACHE;
+      attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+        | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+      break;
+    case LLC_MISSES: attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+    default: return -1;
+  }
+  // This thread, on any CPU
+  return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+Counters::Counters() noexcept {
+  for (int counter = 0; counter < NUM_COUNTERS; ++counter) {
+#ifdef __linux__
+    m_fds[counter] = open_counter((Counter)counter);
+#else
+    m_fds[counter] = -1;
+#endif
+  }
+}
+
+Counters::~Counters() noexcept {
+#ifdef __linux__
+  for (const int fd : m_fds)
+    if (fd >= 0)
+      close(fd);
+#endif
+}
+
+void Counters::reset() noexcept {
+  m_ns = 0;
+#ifdef __linux__
+  for (const int fd : m_fds)
+    if (fd >= 0)
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+#endif
+}
+
+void Counters::start() noexcept {
+#ifdef __linux__
+  for (const int fd : m_fds)
+    if (fd >= 0)
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+  m_start_ns = clock_ns();
+}
+
+void Counters::stop() noexcept {
+  m_ns += clock_ns() - m_start_ns;
+#ifdef __linux__
+  for (const int fd : m_fds)
+    if (fd >= 0)
+      ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+}
+
+sample_t Counters::read() const noexcept {
+  sample_t result;
+  result.ns = m_ns;
+#ifdef __linux__
+  for (int counter = 0; counter < NUM_COUNTERS; ++counter) {
+    // The value, then the times enabled and running
+    uint64_t values[3] = {0, 0, 0};
+    if (m_fds[counter] < 0 || ::read(m_fds[counter], values, sizeof(values)) != sizeof(values))
+      continue;
+    // Never scheduled onto the hardware, e.g. with too few counters
+    if (values[2] == 0 && values[0] == 0 && values[1] != 0)
+      continue;
+    result.counts[counter] = (values[2] == 0 || values[2] == values[1]) ? values[0]
+      : (uint64_t)((double)values[0] * values[1] / values[2]);
+    result.valid[counter] = true;
+  }
+#endif
+  return result;
+}
+
+// Leaf nodes, without the pseudo_moves cache so that only the board is measured
+static size_t perft(Board &board, const int depth) noexcept {
+  if (depth == 0)
+    return 1;
+  size_t result = 0;
+  for (const move_t move : board.generate_moves()) {
+    if (board.make_move(move))
+      result += perft(board, depth - 1);
+    board.unmake_move();
+  }
+  return result;
+}
+
+std::vector<result_t> run(const std::vector<std::string> &fens, const int perft_depth,
+  const size_t repetitions) noexcept {
+  std::vector<Board> boards;
+  for (const std::string &fen : fens)
+    boards.emplace_back(fen);
+
+  // A fixed line of legal moves from every position, picked by the hash so
+  // that every run plays the same moves
+  std::vector<std::vector<move_t>> lines(boards.size());
+  for (size_t idx = 0; idx < boards.size(); ++idx) {
+    Board board = boards[idx];
+    while (lines[idx].size() < LINE_PLIES && !board.is_drawn()) {
+      const std::vector<move_t> moves = board.legal_moves();
+      if (moves.empty())
+        break;
+      lines[idx].push_back(moves[board.hash() % moves.size()]);
+      board.make_move(lines[idx].back());
+    }
+  }
+
+  std::vector<result_t> results;
+  uint64_t total = 0;
+  // body(board, counters) starts and stops the counters around what it
+  // measures, and returns the number of operations measured
+  const auto measure = [&](const std::string &name, const auto &body) {
+    Counters counters;
+    result_t result;
+    result.name = name;
+    for (size_t rep = 0; rep < repetitions; ++rep) {
+      for (size_t idx = 0; idx < boards.size(); ++idx) {
+        Board board = boards[idx];
+        result.operations += body(board, lines[idx], counters);
+      }
+    }
+    result.sample = counters.read();
+    results.push_back(result);
+  };
+
+  measure("make_move", [&](Board &board, const std::vector<move_t> &line, Counters &counters) {
+    counters.start();
+    for (const move_t move : line)
+      total += board.make_move(move);
+    counters.stop();
+    return line.size();
+  });
+  measure("unmake_move", [&](Board &board, const std::vector<move_t> &line, Counters &counters) {
+    for (const move_t move : line)
+      board.make_move(move);
+    counters.start();
+    for (size_t ply = 0; ply < line.size(); ++ply)
+      board.unmake_move();
+    counters.stop();
+    total += board.hash();
+    return line.size();
+  });
+  measure("pseudo_moves", [&](Board &board, const std::vector<move_t> &, Counters &counters) {
+    counters.start();
+    for (int call = 0; call < INNER_CALLS; ++call) {
+      board.m_move_cache.clear();
+      total += board.pseudo_moves().size();
+    }
+    counters.stop();
+    return (size_t)INNER_CALLS;
+  });
+  measure("pseudo_moves (cached)", [&](Board &board, const std::vector<move_t> &, Counters &counters) {
+    board.pseudo_moves();
+    counters.start();
+    for (int call = 0; call < INNER_CALLS; ++call)
+      total += board.pseudo_moves().size();
+    counters.stop();
+    return (size_t)INNER_CALLS;
+  });
+  measure("square_attacked", [&](Board &board, const std::vector<move_t> &, Counters &counters) {
+    counters.start();
+    for (square_t square = 0; square < 64; ++square)
+      total += board.square_attacked(get_square_120(square), WHITE)
+        + board.square_attacked(get_square_120(square), BLACK);
+    counters.stop();
+    return (size_t)128;
+  });
+  measure("legal_moves", [&](Board &board, const std::vector<move_t> &, Counters &counters) {
+    counters.start();
+    for (int call = 0; call < INNER_CALLS; ++call) {
+      board.m_move_cache.clear();
+      total += board.legal_moves().size();
+    }
+    counters.stop();
+    return (size_t)INNER_CALLS;
+  });
+  if (perft_depth > 0) {
+    measure("perft " + std::to_string(perft_depth) + " (per leaf)",
+      [&](Board &board, const std::vector<move_t> &, Counters &counters) {
+      counters.start();
+      const size_t leaves = perft(board, perft_depth);
+      counters.stop();
+      return leaves;
+    });
+  }
+  sink = sink + total;
+  return results;
+}
+
+void report(std::ostream &out, const std::vector<result_t> &results) noexcept {
+  const auto per_op = [&](const result_t &result, const uint64_t value) {
+    return (double)value / std::max<size_t>(result.operations, 1);
+  };
+  out << std::left << std::setw(24) << "operation" << std::right << std::setw(12) << "count"
+    << std::setw(10) << "ns";
+  for (int counter = 0; counter < NUM_COUNTERS; ++counter)
+    out << std::setw(15) << counter_name((Counter)counter);
+  out << std::setw(8) << "IPC" << "\n" << std::fixed << std::setprecision(2);
+  for (const result_t &result : results) {
+    const sample_t &sample = result.sample;
+    out << std::left << std::setw(24) << result.name << std::right << std::setw(12) << result.operations
+      << std::setw(10) << per_op(result, sample.ns);
+    for (int counter = 0; counter < NUM_COUNTERS; ++counter) {
+      if (sample.valid[counter])
+        out << std::setw(15) << per_op(result, sample.counts[counter]);
+      else
+        out << std::setw(15) << "n/a";
+    }
+    if (sample.valid[CYCLES] && sample.valid[INSTRUCTIONS] && sample.counts[CYCLES] > 0)
+      out << std::setw(8) << (double)sample.counts[INSTRUCTIONS] / sample.counts[CYCLES];
+    else
+      out << std::setw(8) << "n/a";
+    out << "\n";
+  }
+  out << std::defaultfloat;
+  bool any_valid = false;
+  for (const result_t &result : results)
+    for (const bool valid : result.sample.valid)
+      any_valid |= valid;
+  if (!any_valid)
+    out << "Hardware counters are unavailable (see /proc/sys/kernel/perf_event_paranoid), "
+      "only wall time was measured\n";
+}
+
+} // namespace hwperf
@@ -0,0 +1,81 @@
+
+#ifndef HWPERF_H
+#define HWPERF_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "defs.hpp"
+
+/*
+HARDWARE PERFORMANCE COUNTERS:
+Cycles, instructions, branch misses and L1 data / last level cache misses of
+this thread, counted by the kernel through perf_event_open on Linux. Only user
+space is counted, so starting and stopping the counters costs nothing that
+shows up in them. Counters the kernel or the hardware does not allow are
+reported as unavailable, and wall time is always measured, so the harness
+still works without any of them (e.g. in containers, or off Linux).
+
+The harness times the board primitives over a corpus of positions, e.g. the
+FEN column of tests/perft.txt, and reports the cost of each per operation.
+*/
+
+namespace hwperf {
+
+enum Counter {
+  CYCLES,
+  INSTRUCTIONS,
+  BRANCH_MISSES,
+  L1D_MISSES,
+  LLC_MISSES,
+  NUM_COUNTERS,
+};
+
+const char *counter_name(const Counter counter) noexcept;
+
+struct sample_t {
+  std::array<uint64_t, NUM_COUNTERS> counts{};
+  std::array<bool, NUM_COUNTERS> valid{};
+  uint64_t ns = 0;
+};
+
+// Counts accumulate over every start/stop pair since the last reset
+class Counters {
+  std::array<int, NUM_COUNTERS> m_fds;
+  uint64_t m_ns = 0, m_start_ns = 0;
+
+public:
+  Counters() noexcept;
+  ~Counters() noexcept;
+  Counters(const Counters &) = delete;
+  Counters &operator=(const Counters &) = delete;
+
+  inline bool available(const Counter counter) const noexcept { return m_fds[counter] >= 0; }
+  void reset() noexcept;
+  void start() noexcept;
+  void stop() noexcept;
+  // Counts are scaled up when the kernel had to multiplex the counters
+  sample_t read() const noexcept;
+};
+
+struct result_t {
+  std::string name;
+  size_t operations = 0;
+  sample_t sample;
+};
+
+// Times each primitive over the positions, repeating every measurement
+// repetitions times, with full perft to perft_depth
+std::vector<result_t> run(const std::vector<std::string> &fens, const int perft_depth,
+  const size_t repetitions) noexcept;
+
+// A table of per-operation costs, with n/a for unavailable counters
+void report(std::ostream &out, const std::vector<result_t> &results) noexcept;
+
+} // namespace hwperf
+
+#endif /* end of include guard: HWPERF_H */
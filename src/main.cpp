@@ -1,21 +1,158 @@
 
+#include <algorithm>
 #include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <string>
+#include <vector>
 
 #include "../tests/runtests.hpp"
 
+#include "analysis.hpp"
 #include "assert.hpp"
+#include "bench.hpp"
 #include "board.hpp"
-#include "hash.hpp"
+#include "hwperf.hpp"
 #include "move.hpp"
 #include "simulate.hpp"
+#include "strategies/search_strat.hpp"
+#include "stats.hpp"
+#include "tb.hpp"
+#include "trace.hpp"
+#include "uci.hpp"
 
-int main() {
-  init_hash();
+// Prints the counters and writes out the trace, when they are compiled in
+static void report_run(std::ostream &out) {
+  stats::report(out);
+#if TRACE_LEVEL > 0
+  if (!trace::dump_chrome("trace.json"))
+    out << "Could not write trace.json\n";
+#endif
+}
+
+int main(int argc, char **argv) {
+  const std::string mode = (argc > 1) ? argv[1] : "";
+  if (mode == "uci") {
+    const int result = uci::loop(std::cin, std::cout);
+    report_run(std::cerr);
+    return result;
+  }
+  if (mode == "bench") {
+    // bench [games] [samples] [seed]
+    const size_t games = (argc > 2) ? std::max(std::atoi(argv[2]), 1) : 32;
+    const size_t samples = (argc > 3) ? std::max(std::atoi(argv[3]), 1) : 15;
+    const uint64_t seed = (argc > 4) ? std::strtoull(argv[4], nullptr, 10) : 1;
+    const std::vector<std::string> corpus = bench::sample_corpus(games, seed);
+    std::cout << corpus.size() << " positions from " << games << " games (seed " << seed << ")\n";
+    bench::report(std::cout, bench::run(corpus, samples));
+    report_run(std::cerr);
+    return 0;
+  }
+  if (mode == "train") {
+    // train [games]: the fixed workload that make pgo profiles
+    const size_t games = (argc > 2) ? std::max(std::atoi(argv[2]), 1) : 64;
+    const bool perft_failed = test_perft("tests/fast_perft.txt", 4);
+    // Random games cover move generation, searched ones the evaluation and search
+    const std::vector<std::string> corpus = bench::sample_corpus(games, 1);
+    search_limits_t limits;
+    limits.depth = 4;
+    size_t num_moves = 0;
+    // A searched game from every 16th of them
+    for (size_t idx = 0; idx < corpus.size(); idx += 16)
+      num_moves += simulate_game(SearchStrategy(limits, 16), SearchStrategy(limits, 16), corpus[idx]).moves.size();
+    std::cout << corpus.size() << " random positions, " << num_moves << " searched moves\n";
+    report_run(std::cerr);
+    return perft_failed;
+  }
+  if (mode == "hwperf") {
+    // hwperf [file] [perft depth] [repetitions]
+    const std::string file_name = (argc > 2) ? argv[2] : "tests/perft.txt";
+    const int depth = (argc > 3) ? std::atoi(argv[3]) : 3;
+    const size_t repetitions = (argc > 4) ? std::max(std::atoi(argv[4]), 1) : 3;
+    std::ifstream file(file_name);
+    std::vector<std::string> fens;
+    std::string line;
+    while (std::getline(file, line)) {
+      const std::string fen = fen_from_epd(line);
+      if (!fen.empty())
+        fens.push_back(fen);
+    }
+    if (fens.empty()) {
+      std::cerr << "No positions in " << file_name << "\n";
+      return 1;
+    }
+    std::cout << fens.size() << " positions from " << file_name << "\n";
+    hwperf::report(std::cout, hwperf::run(fens, depth, repetitions));
+    report_run(std::cerr);
+    return 0;
+  }
+  if (mode == "analyse") {
+    // analyse <file or -> [depth N] [nodes N] [multipv K] [threads T] [hash MB]
+    if (argc < 3) {
+      std::cerr << "Usage: " << argv[0] << " analyse <file> [depth N] [nodes N] [multipv K] [threads T] [hash MB]\n";
+      return 1;
+    }
+    analysis_options_t options;
+    options.limits.depth = 8;
+    for (int idx = 3; idx + 1 < argc; idx += 2) {
+      const std::string option = argv[idx];
+      const long value = std::atol(argv[idx + 1]);
+      if (option == "depth")
+        options.limits.depth = std::clamp<long>(value, 1, MAX_PLY - 1);
+      else if (option == "nodes")
+        options.limits.nodes = std::max<long>(value, 0);
+      else if (option == "multipv")
+        options.limits.multi_pv = std::max<long>(value, 1);
+      else if (option == "threads")
+        options.threads = std::max<long>(value, 1);
+      else if (option == "hash")
+        options.hash_mb = std::max<long>(value, 1);
+    }
+    const std::string file_name = argv[2];
+    std::ifstream file(file_name);
+    if (file_name != "-" && !file) {
+      std::cerr << "Could not open " << file_name << "\n";
+      return 1;
+    }
+    analyse_epd(file_name == "-" ? std::cin : file, std::cout, options);
+    report_run(std::cerr);
+    return 0;
+  }
+  if (mode == "tbgen") {
+    // tbgen <name>... <dir> [threads]
+    std::vector<std::string> args(argv + 2, argv + argc);
+    unsigned threads = 1;
+    if (args.size() >= 3 && args.back().find_first_not_of("0123456789") == std::string::npos) {
+      threads = std::max(std::atoi(args.back().c_str()), 1);
+      args.pop_back();
+    }
+    if (args.size() < 2) {
+      std::cerr << "Usage: " << argv[0] << " tbgen <name>... <dir> [threads]\n";
+      return 1;
+    }
+    const std::string dir = args.back();
+    args.pop_back();
+    int failed = 0;
+    for (const std::string &name : args) {
+      if (!tb::valid_name(name)) {
+        std::cerr << "Bad table name " << name << "\n";
+        failed = 1;
+      } else if (!tb::generate(name, dir, threads)) {
+        std::cerr << "Could not write " << name << " to " << dir << "\n";
+        failed = 1;
+      } else {
+        std::cout << "Generated " << name << " in " << dir << "\n";
+      }
+    }
+    report_run(std::cerr);
+    return failed;
+  }
 
   const int test_error = run_tests("tests/fast_perft.txt", 1000);
   ASSERT_MSG(!test_error, "Tests did not complete successfully");
+  report_run(std::cout);
   printf("Done testing!\n"
   "========================================================================\n");
   return 0;
@@ -0,0 +1,196 @@
+
+#include "mate.hpp"
+
+#include <algorithm>
+
+// Saturating, so that sums of numbers never pass INF
+static inline uint32_t add_numbers(const uint64_t a, const uint64_t b) noexcept {
+  return (uint32_t)std::min<uint64_t>(a + b, MateSolver::INF);
+}
+
+MateSolver::MateSolver(const mate_limits_t &limits) noexcept : m_limits(limits) {
+  // Direct-mapped, with a power of two number of entries
+  const size_t max_entries = std::max<size_t>(1, limits.table_mb * 1024 * 1024 / sizeof(entry_t));
+  size_t num_entries = 1;
+  while (2 * num_entries <= max_entries)
+    num_entries *= 2;
+  m_table.resize(num_entries);
+}
+
+const MateSolver::entry_t *MateSolver::lookup(const hash_t hash, const int ply) const noexcept {
+  const entry_t &entry = m_table[hash & (m_table.size() - 1)];
+  if (entry.key != hash)
+    return nullptr;
+  const int needed = plies_left(ply);
+  if (entry.plies_left == needed)
+    return &entry;
+  // The attacker moves at even plies, and a mate found in fewer plies is
+  // still one in more, while a failure in more plies is one in fewer
+  const bool attacking = ply % 2 == 0;
+  const bool attacker_won = (attacking ? entry.phi : entry.delta) == 0;
+  const bool attacker_lost = (attacking ? entry.delta : entry.phi) == 0;
+  if ((attacker_won && entry.plies_left < needed) || (attacker_lost && entry.plies_left > needed))
+    return &entry;
+  return nullptr;
+}
+
+void MateSolver::store(const hash_t hash, const int ply, const uint32_t phi, const uint32_t delta,
+  const size_t work) noexcept {
+  entry_t &entry = m_table[hash & (m_table.size() - 1)];
+  // Keep the bigger subtree, unless this one is solved
+  const bool solved = phi == 0 || delta == 0;
+  if (entry.key != hash && !solved && entry.work > work)
+    return;
+  // A mate found with more plies left is what the principal variation
+  // follows, so it is kept over anything found with fewer
+  const bool attacking = ply % 2 == 0;
+  if (entry.key == hash && (attacking ? entry.phi : entry.delta) == 0
+    && (attacking ? phi : delta) != 0)
+    return;
+  entry.key = hash;
+  entry.phi = phi;
+  entry.delta = delta;
+  entry.work = (uint32_t)std::min<size_t>(work, UINT32_MAX);
+  entry.plies_left = plies_left(ply);
+}
+
+bool MateSolver::expand(std::vector<child_t> &children, const int ply,
+  uint32_t &phi, uint32_t &delta) noexcept {
+  const bool attacking = m_board.m_next_move_colour == m_attacker;
+  // Draws fail for the attacker, whoever is to move
+  const auto set_draw = [&]() {
+    phi = attacking ? INF : 0;
+    delta = attacking ? 0 : INF;
+    return false;
+  };
+  if (m_board.is_drawn() || (ply > 0 && m_board.is_repetition(1)))
+    return set_draw();
+
+  const bool in_check = m_board.king_in_check();
+  bool has_legal_move = false;
+  children.clear();
+  for (const move_t move : m_board.pseudo_moves()) {
+    if (m_board.make_move(move)) {
+      has_legal_move = true;
+      if (!attacking || !m_limits.checks_only || m_board.king_in_check())
+        children.push_back({move, m_board.m_hash, 1, 1});
+    }
+    m_board.unmake_move();
+  }
+  if (!has_legal_move) {
+    if (!in_check)
+      return set_draw();
+    // Checkmated, so the side to move lost
+    phi = INF;
+    delta = 0;
+    return false;
+  }
+  // Out of checks, or past the longest mate tried
+  if (children.empty() || (m_limits.max_plies > 0 && ply >= m_limits.max_plies))
+    return set_draw();
+
+  for (child_t &child : children) {
+    if (const entry_t *entry = lookup(child.hash, ply + 1)) {
+      child.phi = entry->phi;
+      child.delta = entry->delta;
+    }
+  }
+  return true;
+}
+
+void MateSolver::mid(const uint32_t th_phi, const uint32_t th_delta, const int ply,
+  uint32_t &phi, uint32_t &delta) noexcept {
+  ++m_nodes;
+  const hash_t hash = m_board.m_hash;
+  const size_t start_nodes = m_nodes;
+  std::vector<child_t> children;
+  if (!expand(children, ply, phi, delta)) {
+    if (ply == 0 || !m_board.is_repetition(1))
+      store(hash, ply, phi, delta, 1);
+    return;
+  }
+
+  while (true) {
+    // A node is won if some child is lost, and lost if every child is won
+    phi = INF;
+    delta = 0;
+    size_t best = 0;
+    uint32_t second_delta = INF;
+    for (size_t idx = 0; idx < children.size(); ++idx) {
+      const child_t &child = children[idx];
+      delta = add_numbers(delta, child.phi);
+      if (child.delta < phi) {
+        second_delta = phi;
+        phi = child.delta;
+        best = idx;
+      } else if (child.delta < second_delta) {
+        second_delta = child.delta;
+      }
+    }
+    if (phi >= th_phi || delta >= th_delta || m_stopped)
+      break;
+    if (m_limits.nodes > 0 && m_nodes >= m_limits.nodes) {
+      m_stopped = true;
+      break;
+    }
+
+    child_t &child = children[best];
+    const uint32_t child_th_phi = (th_delta >= INF) ? INF
+      : add_numbers(th_delta - delta, child.phi);
+    const uint32_t child_th_delta = std::min<uint32_t>(th_phi, add_numbers(second_delta, 1));
+    m_board.make_move(child.move);
+    mid(child_th_phi, child_th_delta, ply + 1, child.phi, child.delta);
+    m_board.unmake_move();
+  }
+  store(hash, ply, phi, delta, m_nodes - start_nodes + 1);
+}
+
+std::vector<move_t> MateSolver::principal_variation() noexcept {
+  std::vector<move_t> result;
+  std::vector<child_t> children;
+  uint32_t phi, delta;
+  while (expand(children, (int)result.size(), phi, delta)) {
+    const bool attacking = m_board.m_next_move_colour == m_attacker;
+    // The attacker plays its quickest proven move, the defender its most
+    // stubborn reply; both are children the attacker has proven a win in
+    const child_t *chosen = nullptr;
+    uint32_t chosen_work = 0;
+    for (const child_t &child : children) {
+      const entry_t *entry = lookup(child.hash, (int)result.size() + 1);
+      if (entry == nullptr || (attacking ? entry->delta : entry->phi) != 0)
+        continue;
+      if (chosen == nullptr || (attacking ? entry->work < chosen_work : entry->work > chosen_work)) {
+        chosen = &child;
+        chosen_work = entry->work;
+      }
+    }
+    // Entries may have been overwritten, in which case the line stops early
+    if (chosen == nullptr)
+      break;
+    result.push_back(chosen->move);
+    m_board.make_move(chosen->move);
+  }
+  for (size_t idx = 0; idx < result.size(); ++idx)
+    m_board.unmake_move();
+  return result;
+}
+
+mate_result_t MateSolver::solve(const Board &board) noexcept {
+  std::fill(m_table.begin(), m_table.end(), entry_t());
+  m_board = board;
+  m_attacker = board.m_next_move_colour;
+  m_nodes = 0;
+  m_stopped = false;
+
+  mate_result_t result;
+  uint32_t phi, delta;
+  mid(INF, INF, 0, phi, delta);
+  result.nodes = m_nodes;
+  if (phi == 0) {
+    result.status = MATE_PROVEN;
+    result.pv = principal_variation();
+  } else if (delta == 0) {
+    result.status = MATE_DISPROVEN;
+  }
+  return result;
+}
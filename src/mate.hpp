@@ -0,0 +1,93 @@
+
+#ifndef MATE_H
+#define MATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "defs.hpp"
+#include "board.hpp"
+#include "move.hpp"
+
+/*
+DF-PN MATE SOLVER:
+Depth-first proof-number search for a forced mate by the side to move (the
+attacker). Each node keeps two numbers from its own side to move's point of
+view: phi, the cost of proving that side wins, and delta, the cost of proving
+it does not. A won node has phi = 0, a lost one delta = 0. The search descends
+into the most promising child until its numbers cross thresholds derived from
+its parent's, and stores the numbers in a transposition table so that the
+tree itself never has to be kept.
+
+Stalemates, draws, and positions past max_plies count as failures for the
+attacker. Repetitions do too, but are not stored, as they depend on the path.
+With max_plies, results also depend on the plies left, which are stored with
+them: a proof holds with more plies left, a disproof with fewer, and unsolved
+numbers only for the same.
+*/
+
+enum MateStatus { MATE_PROVEN, MATE_DISPROVEN, MATE_UNKNOWN };
+
+struct mate_limits_t {
+  size_t nodes = 0;        // 0 for no limit
+  size_t table_mb = 16;    // Transposition table size
+  int max_plies = 0;       // 0 for no limit, otherwise the longest mate tried
+  bool checks_only = false; // The attacker may only give check
+};
+
+struct mate_result_t {
+  MateStatus status = MATE_UNKNOWN;
+  // A forced mate when proven, ending in checkmate. The defender plays the
+  // replies with the largest proofs, so it is long but not always the longest.
+  std::vector<move_t> pv;
+  size_t nodes = 0;
+};
+
+class MateSolver {
+  struct entry_t {
+    hash_t key = 0;
+    uint32_t phi = 0, delta = 0;
+    uint32_t work = 0; // Nodes spent below this entry, for the PV
+    int32_t plies_left = 0; // Always 0 without max_plies
+  };
+  struct child_t {
+    move_t move;
+    hash_t hash;
+    uint32_t phi, delta;
+  };
+
+  std::vector<entry_t> m_table;
+  mate_limits_t m_limits;
+  Board m_board;
+  bool m_attacker = WHITE;
+  size_t m_nodes = 0;
+  bool m_stopped = false;
+
+  inline int plies_left(const int ply) const noexcept {
+    return m_limits.max_plies > 0 ? m_limits.max_plies - ply : 0;
+  }
+  // The entry for a node at ply, if its numbers hold there
+  const entry_t *lookup(const hash_t hash, const int ply) const noexcept;
+  void store(const hash_t hash, const int ply, const uint32_t phi, const uint32_t delta,
+    const size_t work) noexcept;
+  // Fills children with the moves to search, false if the node is terminal,
+  // in which case phi and delta are set
+  bool expand(std::vector<child_t> &children, const int ply, uint32_t &phi,
+    uint32_t &delta) noexcept;
+  // Searches the current position until phi >= th_phi or delta >= th_delta
+  void mid(const uint32_t th_phi, const uint32_t th_delta, const int ply,
+    uint32_t &phi, uint32_t &delta) noexcept;
+  std::vector<move_t> principal_variation() noexcept;
+
+public:
+  static constexpr uint32_t INF = 1u << 30;
+
+  explicit MateSolver(const mate_limits_t &limits = mate_limits_t()) noexcept;
+
+  mate_result_t solve(const Board &board) noexcept;
+  inline mate_result_t solve(const std::string &fen) noexcept { return solve(Board(fen)); }
+};
+
+#endif /* end of include guard: MATE_H */
@@ -0,0 +1,129 @@
+
+#include "material.hpp"
+#include "eval.hpp"
+
+#include <vector>
+
+// Bonuses from white's point of view; black's are negated
+constexpr psq_t bishop_pair_bonus = {30, 50};
+// Per own pawn above five: knights gain from closed positions, rooks lose
+constexpr int knight_pawn_bonus = 6, rook_pawn_bonus = -12;
+
+material_key_t compute_material_key(const std::array<unsigned, 16> &counts) noexcept {
+  material_key_t result = 0;
+  for (piece_t piece = 0; piece < 16; ++piece)
+    result += material_weight[piece] * counts[piece];
+  return result;
+}
+
+bool material_in_table(const std::array<unsigned, 16> &counts) noexcept {
+  for (piece_t piece = 0; piece < 16; ++piece)
+    if (material_weight[piece] != 0 && counts[piece] > material::piece_cap[piece])
+      return false;
+  return true;
+}
+
+// Material values without kings or pawns
+static int non_pawn_material(const std::array<unsigned, 16> &counts,
+  const int side) noexcept {
+  const piece_t base = (side == WHITE) ? 0 : 8;
+  return counts[base + WHITE_QUEEN] * piece_value[WHITE_QUEEN]
+    + counts[base + WHITE_ROOK] * piece_value[WHITE_ROOK]
+    + counts[base + WHITE_BISHOP] * piece_value[WHITE_BISHOP]
+    + counts[base + WHITE_KNIGHT] * piece_value[WHITE_KNIGHT];
+}
+
+material_entry_t compute_material(const std::array<unsigned, 16> &counts) noexcept {
+  material_entry_t entry;
+  int phase = 0;
+  for (piece_t piece = 0; piece < 16; ++piece)
+    phase += phase_weight[piece] * counts[piece];
+  entry.phase = phase;
+
+  for (const int side : {WHITE, BLACK}) {
+    const piece_t base = (side == WHITE) ? 0 : 8;
+    const int sign = (side == WHITE) ? 1 : -1;
+    const int pawns = counts[base + WHITE_PAWN];
+    if (counts[base + WHITE_BISHOP] >= 2) {
+      entry.imbalance.mg += sign * bishop_pair_bonus.mg;
+      entry.imbalance.eg += sign * bishop_pair_bonus.eg;
+    }
+    const int adjust = (pawns - 5) * (knight_pawn_bonus * counts[base + WHITE_KNIGHT]
+      + rook_pawn_bonus * counts[base + WHITE_ROOK]);
+    entry.imbalance.mg += sign * adjust;
+    entry.imbalance.eg += sign * adjust;
+  }
+
+  const int npm[2] = {non_pawn_material(counts, WHITE), non_pawn_material(counts, BLACK)};
+  const unsigned pawns[2] = {counts[WHITE_PAWN], counts[BLACK_PAWN]};
+
+  // Nothing but kings and at most one minor piece
+  if (pawns[WHITE] + pawns[BLACK] == 0
+    && npm[WHITE] + npm[BLACK] <= piece_value[WHITE_BISHOP]) {
+    entry.drawn = true;
+    entry.scale = {0, 0};
+    return entry;
+  }
+
+  for (const int side : {WHITE, BLACK}) {
+    const int other = !side;
+    const piece_t base = (side == WHITE) ? 0 : 8;
+    if (pawns[side] != 0)
+      continue;
+    if (npm[side] - npm[other] <= piece_value[WHITE_BISHOP])
+      entry.scale[side] = (npm[side] < piece_value[WHITE_ROOK]) ? 0 : SCALE_NORMAL / 4;
+    // Two knights cannot force mate against a bare king
+    if (npm[side] == 2 * piece_value[WHITE_KNIGHT] && counts[base + WHITE_KNIGHT] == 2
+      && npm[other] == 0 && pawns[other] == 0)
+      entry.scale[side] = 0;
+  }
+
+  for (const int side : {WHITE, BLACK}) {
+    const int other = !side;
+    const piece_t base = (side == WHITE) ? 0 : 8;
+    if (npm[other] != 0 || pawns[other] != 0)
+      continue;
+    const unsigned bishops = counts[base + WHITE_BISHOP], knights = counts[base + WHITE_KNIGHT];
+    if (npm[side] == 0 && pawns[side] == 1)
+      entry.endgame = KPK_ENDGAME;
+    else if (pawns[side] == 0 && bishops == 1 && knights == 1
+      && npm[side] == piece_value[WHITE_BISHOP] + piece_value[WHITE_KNIGHT])
+      entry.endgame = KBNK_ENDGAME;
+    else if (counts[base + WHITE_QUEEN] + counts[base + WHITE_ROOK] != 0
+      || bishops >= 2 || (bishops != 0 && knights != 0))
+      entry.endgame = KXK_ENDGAME;
+    if (entry.endgame != NO_ENDGAME)
+      entry.strong_side = side;
+  }
+  return entry;
+}
+
+static const std::vector<material_entry_t> &material_table() noexcept {
+  static const std::vector<material_entry_t> table = [] {
+    std::vector<material_entry_t> result(MATERIAL_TABLE_SIZE);
+    for (material_key_t key = 0; key < MATERIAL_TABLE_SIZE; ++key) {
+      std::array<unsigned, 16> counts{};
+      material_key_t rest = key;
+      for (piece_t piece = 0; piece < 16; ++piece) {
+        if (material_weight[piece] == 0)
+          continue;
+        counts[piece] = rest % (material::piece_cap[piece] + 1);
+        rest /= material::piece_cap[piece] + 1;
+      }
+      ASSERT(compute_material_key(counts) == key);
+      result[key] = compute_material(counts);
+    }
+    return result;
+  }();
+  return table;
+}
+
+const material_entry_t &probe_material(const Board &board,
+  material_entry_t &scratch) noexcept {
+  if (material_in_table(board.m_num_pieces)) {
+    ASSERT(board.m_material_key < MATERIAL_TABLE_SIZE);
+    return material_table()[board.m_material_key];
+  }
+  scratch = compute_material(board.m_num_pieces);
+  return scratch;
+}
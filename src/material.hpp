@@ -0,0 +1,85 @@
+
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <array>
+#include <cstdint>
+
+#include "defs.hpp"
+#include "board.hpp"
+#include "piece.hpp"
+#include "psqt.hpp"
+
+/*
+MATERIAL KEY:
+- a mixed radix number with one digit per piece type, so it can be updated by
+  adding or subtracting a weight whenever a piece appears or disappears
+- each digit is capped at the starting count: pawns 0-8, knights, bishops and
+  rooks 0-2, queens 0-1; kings are always there and have no digit
+- beyond the caps (after promotions) the key carries into the next digit, so
+  it is still restored exactly, but such positions are scored without the table
+*/
+using material_key_t = uint32_t;
+
+namespace material {
+
+constexpr unsigned piece_cap[16] = {
+  1, 2, 8, 0, 2, 2, 0, 0,
+  1, 2, 8, 0, 2, 2, 0, 0,
+};
+
+constexpr std::array<material_key_t, 16> make_weights() noexcept {
+  std::array<material_key_t, 16> result{};
+  material_key_t weight = 1;
+  for (int piece = 0; piece < 16; ++piece) {
+    if (piece_cap[piece] == 0)
+      continue;
+    result[piece] = weight;
+    weight *= piece_cap[piece] + 1;
+  }
+  return result;
+}
+
+} // namespace material
+
+// Key weight of each piece, 0 for kings and the unused piece codes
+constexpr std::array<material_key_t, 16> material_weight = material::make_weights();
+enum { MATERIAL_TABLE_SIZE = 486 * 486 };
+
+// Endgames with a specialised evaluation, see endgame.hpp
+enum EndgameType : uint8_t {
+  NO_ENDGAME, KPK_ENDGAME, KBNK_ENDGAME, KXK_ENDGAME,
+};
+
+// Scale factors are out of SCALE_NORMAL
+enum { SCALE_NORMAL = 64 };
+
+/*
+MATERIAL ENTRY:
+- imbalance   - bishop pair, and knights and rooks by the number of own pawns
+- phase       - game phase, as in psqt.hpp, not clamped to MAX_PHASE
+- drawn       - neither side can ever mate (KK, KNK, KBK)
+- endgame     - specialised evaluator, for strong_side against a bare king
+- scale       - applied to the score while that side is ahead, for material
+                that is hard to win with
+*/
+struct material_entry_t {
+  psq_t imbalance;
+  uint8_t phase = 0;
+  bool drawn = false;
+  EndgameType endgame = NO_ENDGAME;
+  uint8_t strong_side = WHITE;
+  std::array<uint8_t, 2> scale = {SCALE_NORMAL, SCALE_NORMAL};
+};
+
+material_key_t compute_material_key(const std::array<unsigned, 16> &counts) noexcept;
+bool material_in_table(const std::array<unsigned, 16> &counts) noexcept;
+// Computes the entry for the given piece counts from scratch
+material_entry_t compute_material(const std::array<unsigned, 16> &counts) noexcept;
+
+// The table is built on first use and shared by all threads. Boards beyond
+// the digit caps are computed into scratch, which is then returned.
+const material_entry_t &probe_material(const Board &board,
+  material_entry_t &scratch) noexcept;
+
+#endif /* end of include guard: MATERIAL_H */
@@ -2,6 +2,7 @@
 #ifndef MOVE_H
 #define MOVE_H
 
+#include <cctype>
 #include <cstdint>
 #include <string>
 #include <sstream>
@@ -13,15 +14,16 @@
 
 /*
 MOVE:
-- from square - 8 bits
-- to square - 8 bits
+- from square - 6 bits (0-63, see get_square_64)
+- to square - 6 bits
 - flag - 4 bits
-- moving piece - 4 bits
-- captured piece - 4 bits
 
 FLAG:
 promoted | captured | spec1 | spec0
-TOTAL: 28 bits
+TOTAL: 16 bits
+
+The moved and captured pieces are read off the board by make_move, and kept in
+its history entry for unmake_move.
 */
 
 enum MoveFlag {
@@ -61,30 +63,34 @@ string_from_flag(const MoveFlag flag) {
   return lut[flag];
 }
 
-constexpr inline move_t
-create_move(const square_t from, const square_t to, const MoveFlag flag,
-  const piece_t moving, const piece_t captured) {
-  return (from << 0) | (to << 8) | (flag << 16) | (moving << 20)
-  | (captured << 24);
+// Never a real move (from and to are both a1)
+constexpr move_t NULL_MOVE = 0;
+
+// Same as get_square_64 and get_square_120, without the table lookups on the
+// move generation and make_move paths
+constexpr inline unsigned square_64_from_120(const square_t square) {
+  return (square - 21) - 2 * ((square - 21) / 10);
+}
+constexpr inline square_t square_120_from_64(const unsigned square) {
+  return 21 + square + 2 * (square >> 3);
 }
 
+constexpr inline move_t
+create_move(const square_t from, const square_t to, const MoveFlag flag) {
+  return (square_64_from_120(from) << 0) | (square_64_from_120(to) << 6) | (flag << 12);
+}
 constexpr inline square_t move_from(const move_t move) {
-  return (move >> 0) & 0xFF;
+  return square_120_from_64((move >> 0) & 0x3F);
 }
 constexpr inline square_t move_to(const move_t move) {
-  return (move >> 8) & 0xFF;
+  return square_120_from_64((move >> 6) & 0x3F);
 }
 constexpr inline MoveFlag move_flag(const move_t move) {
-  return (MoveFlag)((move >> 16) & 0xF);
-}
-constexpr inline piece_t moved_piece(const move_t move) {
-  return (move >> 20) & 0xF;
-}
-constexpr inline piece_t captured_piece(const move_t move) {
-  return (move >> 24) & 0xF;
+  return (MoveFlag)((move >> 12) & 0xF);
 }
+// The side is that of the rank promoted on
 constexpr inline piece_t promoted_piece(const move_t move) {
-  const bool side = get_side(moved_piece(move));
+  const bool side = (get_square_row(move_to(move)) == RANK_8) ? WHITE : BLACK;
   switch (move_flag(move)) {
     case PROMOTE_KNIGHT_MOVE:
     case PROMOTE_KNIGHT_CAPTURE_MOVE:
@@ -103,10 +109,14 @@ constexpr inline piece_t promoted_piece(const move_t move) {
   }
 }
 constexpr inline bool move_captured(const move_t move) {
-  return (move >> 18) & 1;
+  return (move >> 14) & 1;
 }
 constexpr inline bool move_promoted(const move_t move) {
-  return (move >> 19) & 1;
+  return (move >> 15) & 1;
+}
+constexpr inline bool is_queen_promotion(const move_t move) {
+  const MoveFlag flag = move_flag(move);
+  return flag == PROMOTE_QUEEN_MOVE || flag == PROMOTE_QUEEN_CAPTURE_MOVE;
 }
 constexpr inline bool move_castled(const move_t move) {
   const MoveFlag flag = move_flag(move);
@@ -114,6 +124,8 @@ constexpr inline bool move_castled(const move_t move) {
 }
 
 inline std::string string_from_move(const move_t move) {
+  if (move == NULL_MOVE)
+    return "0000";
   const square_t from = move_from(move), to = move_to(move);
   std::stringstream res;
   res << string_from_square(from);
@@ -125,7 +137,20 @@ inline std::string string_from_move(const move_t move) {
   return res.str();
 }
 
+// Long algebraic notation as UCI expects it, e.g. "e7e8q"
+inline std::string uci_from_move(const move_t move) {
+  if (move == NULL_MOVE)
+    return "0000";
+  std::string res = string_from_square(move_from(move)) + string_from_square(move_to(move));
+  if (move_promoted(move))
+    res += (char)std::tolower(char_from_piece(promoted_piece(move)));
+  return res;
+}
+
 inline void validate_move(const move_t move, const Board board) {
+  const piece_t moved = board.piece_at(move_from(move));
+  const piece_t captured = (move_flag(move) == EN_PASSANT_MOVE) ? (piece_t)(moved ^ 8u)
+    : board.piece_at(move_to(move));
   // General tests
   ASSERT_MSG(valid_square(move_from(move)),
     "Move contained invalid from square (%u)", move_from(move));
@@ -133,121 +158,98 @@ inline void validate_move(const move_t move, const Board board) {
     "Move contained invalid to square (%u)", move_to(move));
   ASSERT_MSG(move_flag(move) != 6 && move_flag(move) != 7,
     "Move contained invalid flag (%u)", move_flag(move));
-  ASSERT_MSG(valid_piece(moved_piece(move)),
-    "Move contained invalid moved piece (%u)", moved_piece(move));
-  ASSERT_MSG(valid_piece(captured_piece(move))
-    || captured_piece(move) == INVALID_PIECE,
-    "Move contained neither vaild captured piece nor INVALID_PIECE (%u)",
-    captured_piece(move));
-
-  // Board checks
-  ASSERT_MSG(moved_piece(move) == board.piece_at(move_from(move)),
-    "Moved piece (%u) disagrees with board (board[%u] = %u)",
-    moved_piece(move), move_from(move), board.piece_at(move_from(move)));
-  ASSERT_IF_MSG(move_captured(move),
-    captured_piece(move) == board.piece_at(move_to(move)),
-    "Captured piece (%u) disagrees with board (board[%u] = %u)",
-    captured_piece(move), move_to(move), board.piece_at(move_to(move)));
+  ASSERT_MSG(valid_piece(moved),
+    "No piece on the from square (%u) of the move", move_from(move));
+  ASSERT_MSG(get_side(moved) == board.m_next_move_colour,
+    "Moved piece (%u) is not of the side to move", moved);
+  ASSERT_IF_MSG(!move_captured(move), captured == INVALID_PIECE,
+    "Quiet move to occupied square (board[%u] = %u)", move_to(move), captured);
 
   // Capture moves
-  ASSERT_IF_MSG(move_captured(move), valid_piece(captured_piece(move)),
-    "Piece was captured, but invalid captured piece (%u) in move",
-    captured_piece(move));
+  ASSERT_IF_MSG(move_captured(move), valid_piece(captured),
+    "Piece was captured, but invalid captured piece (%u) on the board",
+    captured);
   ASSERT_IF_MSG(move_captured(move),
-    opposite_colours(captured_piece(move), moved_piece(move)),
+    opposite_colours(captured, moved),
     "Captured own piece (moved = %u, captured = %u)",
-    moved_piece(move), captured_piece(move));
-  ASSERT_IF_MSG(move_captured(move), !is_king(captured_piece(move)),
-    "Captured king (%u)", captured_piece(move));
+    moved, captured);
+  ASSERT_IF_MSG(move_captured(move), !is_king(captured),
+    "Captured king (%u)", captured);
 
   // Promotion moves
-  ASSERT_IF_MSG(move_promoted(move), is_pawn(moved_piece(move)),
-    "Promoted from non-pawn piece (%u)", moved_piece(move));
-  ASSERT_IF_MSG(move_promoted(move) && get_side(moved_piece(move)) == WHITE,
+  ASSERT_IF_MSG(move_promoted(move), is_pawn(moved),
+    "Promoted from non-pawn piece (%u)", moved);
+  ASSERT_IF_MSG(move_promoted(move) && get_side(moved) == WHITE,
     get_square_row(move_to(move)) == RANK_8,
     "White pawn promoted to square (%u) not on 8th rank", move_to(move));
-  ASSERT_IF_MSG(move_promoted(move) && get_side(moved_piece(move)) == BLACK,
+  ASSERT_IF_MSG(move_promoted(move) && get_side(moved) == BLACK,
     get_square_row(move_to(move)) == RANK_1,
     "Black pawn promoted to square (%u) not on 1st rank", move_to(move));
 
   // Castling moves
   ASSERT_IF_MSG(move_flag(move) == SHORT_CASTLE_MOVE
-    && get_side(moved_piece(move)) == WHITE,
-    moved_piece(move) == WHITE_KING
+    && get_side(moved) == WHITE,
+    moved == WHITE_KING
     && move_from(move) == E1 && move_to(move) == G1
     && board.can_castle(WHITE_SHORT),
     "Short white castle move: Moved piece (%u) was not wK OR squares (%u -> %u)"
     " did not match OR castling disallowed",
-    moved_piece(move), move_from(move), move_to(move));
+    moved, move_from(move), move_to(move));
 
   ASSERT_IF_MSG(move_flag(move) == LONG_CASTLE_MOVE
-    && get_side(moved_piece(move)) == WHITE,
-    moved_piece(move) == WHITE_KING
+    && get_side(moved) == WHITE,
+    moved == WHITE_KING
     && move_from(move) == E1 && move_to(move) == C1
     && board.can_castle(WHITE_LONG),
     "Long white castle move: Moved piece (%u) was not wK OR squares (%u -> %u)"
     " did not match OR castling disallowed",
-    moved_piece(move), move_from(move), move_to(move));
+    moved, move_from(move), move_to(move));
 
   ASSERT_IF_MSG(move_flag(move) == SHORT_CASTLE_MOVE
-    && get_side(moved_piece(move)) == BLACK,
-    moved_piece(move) == BLACK_KING
+    && get_side(moved) == BLACK,
+    moved == BLACK_KING
     && move_from(move) == E8 && move_to(move) == G8
     && board.can_castle(BLACK_SHORT),
     "Short black castle move: Moved piece (%u) was not bK OR squares (%u -> %u)"
     " did not match OR castling disallowed",
-    moved_piece(move), move_from(move), move_to(move));
+    moved, move_from(move), move_to(move));
 
   ASSERT_IF_MSG(move_flag(move) == LONG_CASTLE_MOVE
-    && get_side(moved_piece(move)) == BLACK,
-    moved_piece(move) == BLACK_KING
+    && get_side(moved) == BLACK,
+    moved == BLACK_KING
     && move_from(move) == E8 && move_to(move) == C8
     && board.can_castle(BLACK_LONG),
     "Long black castle move: Moved piece (%u) was not bK OR squares (%u -> %u)"
     " did not match OR castling disallowed",
-    moved_piece(move), move_from(move), move_to(move));
+    moved, move_from(move), move_to(move));
 }
 
 constexpr inline move_t
-quiet_move(const square_t from, const square_t to, const piece_t moving) {
+quiet_move(const square_t from, const square_t to) {
   ASSERT_MSG(valid_square(from), "Invalid from square (%u)", from);
   ASSERT_MSG(valid_square(to), "Invalid to square (%u)", to);
   ASSERT(from != to);
-  ASSERT(moving != INVALID_PIECE);
-  return create_move(from, to, QUIET_MOVE, moving, INVALID_PIECE);
+  return create_move(from, to, QUIET_MOVE);
 }
 
 constexpr inline move_t
-capture_move(const square_t from, const square_t to, const piece_t moving, const piece_t captured) {
+capture_move(const square_t from, const square_t to) {
   ASSERT_MSG(valid_square(from), "Invalid from square (%u)", from);
   ASSERT_MSG(valid_square(to), "Invalid to square (%u)", to);
   ASSERT(from != to);
-  ASSERT(moving != INVALID_PIECE);
-  ASSERT(captured != INVALID_PIECE);
-  ASSERT_MSG(opposite_colours(moving, captured),
-    "Moved (%u) and captured (%u) pieces not opposite", moving, captured);
-  return create_move(from, to, CAPTURE_MOVE, moving, captured);
+  return create_move(from, to, CAPTURE_MOVE);
 }
 
 constexpr inline move_t
-double_move(const square_t from, const square_t to, const piece_t moving) {
+double_move(const square_t from, const square_t to) {
   ASSERT_MSG(valid_square(from), "Invalid from square (%u)", from);
   ASSERT_MSG(valid_square(to), "Invalid to square (%u)", to);
-  ASSERT(from != to);
-  ASSERT_MSG(is_pawn(moving), "Double move for non-pawn (%u) piece", moving);
-  return create_move(from, to, DOUBLE_PAWN_MOVE, moving, INVALID_PIECE);
+  ASSERT_MSG(to == from + 20 || to + 20 == from, "Double move from %u to %u", from, to);
+  return create_move(from, to, DOUBLE_PAWN_MOVE);
 }
 
-constexpr inline move_t
-promote_move(const square_t from, const square_t to,
-             const piece_t moving, const piece_t promote_piece) {
-  ASSERT_MSG(valid_square(from), "Invalid from square (%u)", from);
-  ASSERT_MSG(valid_square(to), "Invalid to square (%u)", to);
-  ASSERT(from != to);
-  ASSERT_MSG((get_square_row(to) == RANK_1 && get_side(moving) == BLACK)
-    || (get_square_row(to) == RANK_8 && get_side(moving) == WHITE),
-      "Promoting to square (%u) not on rank 1 or 8", to);
-  ASSERT_MSG(is_pawn(moving), "Promote move for non-pawn (%u) piece", moving);
+// The flag of a promotion to the given piece, of either colour
+constexpr inline MoveFlag promote_flag(const piece_t promote_piece, const bool capture) {
   unsigned flag = 0;
   switch (promote_piece) {
     case WHITE_KNIGHT:
@@ -269,55 +271,40 @@ promote_move(const square_t from, const square_t to,
     default:
       ASSERT_MSG(0, "Invalid promote piece (%u)", promote_piece);
   }
-  return create_move(from, to, (MoveFlag)flag, moving, INVALID_PIECE);
+  return (MoveFlag)(capture ? (flag | CAPTURE_MOVE) : flag);
 }
 
 constexpr inline move_t
-promote_capture_move(const square_t from, const square_t to,
-                     const piece_t moving, const piece_t promote_piece,
-                     const piece_t capture_piece) {
+promote_move(const square_t from, const square_t to, const piece_t promote_piece) {
   ASSERT_MSG(valid_square(from), "Invalid from square (%u)", from);
   ASSERT_MSG(valid_square(to), "Invalid to square (%u)", to);
   ASSERT(from != to);
-  ASSERT_MSG((get_square_row(to) == RANK_1 && get_side(moving) == BLACK)
-   || (get_square_row(to) == RANK_8 && get_side(moving) == WHITE),
-     "Promoting to square (%u) not on rank 1 or 8", to);
-  ASSERT_MSG(is_pawn(moving), "Promote move for non-pawn (%u) piece", moving);
-  unsigned flag = 0;
-  switch (promote_piece) {
-    case WHITE_KNIGHT:
-    case BLACK_KNIGHT:
-      flag = PROMOTE_KNIGHT_CAPTURE_MOVE;
-      break;
-    case WHITE_BISHOP:
-    case BLACK_BISHOP:
-      flag = PROMOTE_BISHOP_CAPTURE_MOVE;
-      break;
-    case WHITE_ROOK:
-    case BLACK_ROOK:
-      flag = PROMOTE_ROOK_CAPTURE_MOVE;
-      break;
-    case WHITE_QUEEN:
-    case BLACK_QUEEN:
-      flag = PROMOTE_QUEEN_CAPTURE_MOVE;
-      break;
-    default:
-      ASSERT_MSG(0, "Invalid promote piece (%u)", promote_piece);
-  }
-  return create_move(from, to, (MoveFlag)flag, moving, capture_piece);
+  ASSERT_MSG(get_square_row(to) == RANK_1 || get_square_row(to) == RANK_8,
+    "Promoting to square (%u) not on rank 1 or 8", to);
+  return create_move(from, to, promote_flag(promote_piece, false));
+}
+
+constexpr inline move_t
+promote_capture_move(const square_t from, const square_t to, const piece_t promote_piece) {
+  ASSERT_MSG(valid_square(from), "Invalid from square (%u)", from);
+  ASSERT_MSG(valid_square(to), "Invalid to square (%u)", to);
+  ASSERT(from != to);
+  ASSERT_MSG(get_square_row(to) == RANK_1 || get_square_row(to) == RANK_8,
+    "Promoting to square (%u) not on rank 1 or 8", to);
+  return create_move(from, to, promote_flag(promote_piece, true));
 }
 
 constexpr inline move_t
-en_passant_move(const square_t from, const square_t to, const piece_t moving) {
+en_passant_move(const square_t from, const square_t to) {
   ASSERT_MSG(valid_square(from), "Invalid from square (%u)", from);
   ASSERT_MSG(valid_square(to), "Invalid to square (%u)", to);
   ASSERT(from != to);
-  return create_move(from, to, EN_PASSANT_MOVE, moving, moving ^ 8u);
+  return create_move(from, to, EN_PASSANT_MOVE);
 }
 
 constexpr inline move_t
-castle_move(const square_t from, const square_t to, const piece_t moving, const MoveFlag flag) {
-  return create_move(from, to, flag, moving, INVALID_PIECE);
+castle_move(const square_t from, const square_t to, const MoveFlag flag) {
+  return create_move(from, to, flag);
 }
 
 #endif /* end of include guard: MOVE_H */
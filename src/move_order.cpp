@@ -0,0 +1,96 @@
+
+#include "move_order.hpp"
+#include "eval.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+// Attacker rank for MVV-LVA, indexed by piece (king last, it rarely recaptures)
+constexpr int lva_rank[16] = {
+  4, 3, 0, 0, 2, 1, 5, 0,
+  4, 3, 0, 0, 2, 1, 5, 0,
+};
+
+int mvv_lva(const Board &board, const move_t move) noexcept {
+  const square_t from = move_from(move), to = move_to(move);
+  const piece_t attacker = board.piece_at(from);
+  // The en passant victim is not on the to-square
+  const piece_t victim = (move_flag(move) == EN_PASSANT_MOVE)
+    ? (attacker ^ 8u) : board.piece_at(to);
+  int score = (victim == INVALID_PIECE) ? 0 : 8 * piece_value[victim];
+  if (is_queen_promotion(move))
+    score += 8 * piece_value[WHITE_QUEEN];
+  return score - lva_rank[attacker];
+}
+
+void MoveOrder::clear() noexcept {
+  for (auto &killers : m_killers)
+    killers.fill(NULL_MOVE);
+  for (auto &history : m_history)
+    history.fill(0);
+  for (auto &counters : m_counter_moves)
+    counters.fill(NULL_MOVE);
+}
+
+move_t MoveOrder::counter_move(const Board &board) const noexcept {
+  if (board.m_history.empty())
+    return NULL_MOVE;
+  const move_t previous = board.m_history.back().move;
+  if (previous == NULL_MOVE)
+    return NULL_MOVE;
+  const square_t to = move_to(previous);
+  return m_counter_moves[board.piece_at(to)][to];
+}
+
+void MoveOrder::score_moves(const Board &board, const std::vector<move_t> &moves,
+  std::vector<int> &scores, const move_t tt_move, const int ply) const noexcept {
+  ASSERT(0 <= ply && ply <= MAX_PLY);
+  const move_t counter = counter_move(board);
+  scores.resize(moves.size());
+  for (size_t idx = 0; idx < moves.size(); ++idx) {
+    const move_t move = moves[idx];
+    if (move == tt_move) {
+      scores[idx] = TT_MOVE_SCORE;
+    } else if (move_captured(move) || is_queen_promotion(move)) {
+      const int base = board.see_ge(move, 0) ? CAPTURE_SCORE : BAD_CAPTURE_SCORE;
+      scores[idx] = base + mvv_lva(board, move);
+    } else if (move_promoted(move)) {
+      scores[idx] = UNDER_PROMOTE_SCORE;
+    } else if (move == m_killers[ply][0]) {
+      scores[idx] = KILLER_SCORE + 1;
+    } else if (move == m_killers[ply][1]) {
+      scores[idx] = KILLER_SCORE;
+    } else if (move == counter) {
+      scores[idx] = COUNTER_SCORE;
+    } else {
+      scores[idx] = history(board, move);
+    }
+  }
+}
+
+// History gravity: large bonuses saturate towards MAX_HISTORY instead of
+// overflowing, and old statistics decay as new ones arrive
+static inline void update_history(int &entry, const int bonus) noexcept {
+  entry += bonus - entry * std::abs(bonus) / MAX_HISTORY;
+  ASSERT(-MAX_HISTORY <= entry && entry <= MAX_HISTORY);
+}
+
+void MoveOrder::update_quiet_stats(const Board &board, const move_t best,
+  const std::vector<move_t> &tried, const int depth, const int ply) noexcept {
+  ASSERT(move_is_quiet(best));
+  if (m_killers[ply][0] != best) {
+    m_killers[ply][1] = m_killers[ply][0];
+    m_killers[ply][0] = best;
+  }
+
+  if (!board.m_history.empty() && board.m_history.back().move != NULL_MOVE) {
+    const square_t to = move_to(board.m_history.back().move);
+    m_counter_moves[board.piece_at(to)][to] = best;
+  }
+
+  const int bonus = std::min(depth * depth, MAX_HISTORY / 16);
+  update_history(m_history[board.piece_at(move_from(best))][move_to(best)], bonus);
+  for (const move_t move : tried)
+    if (move != best)
+      update_history(m_history[board.piece_at(move_from(move))][move_to(move)], -bonus);
+}
@@ -0,0 +1,88 @@
+
+#ifndef MOVE_ORDER_H
+#define MOVE_ORDER_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "defs.hpp"
+#include "board.hpp"
+#include "move.hpp"
+#include "search.hpp"
+
+/*
+MOVE SCORES (higher is searched first):
+- TT move                    - 1 << 30
+- Captures, queen promotions - 1 << 24 + MVV-LVA, if they do not lose material
+- Killers                    - 1 << 22 (first slot +1)
+- Counter move               - 1 << 21
+- Other quiets               - butterfly history, in [-MAX_HISTORY, MAX_HISTORY]
+- Losing captures            - -(1 << 20) + MVV-LVA, by static exchange
+- Under-promotions           - -(1 << 24)
+*/
+enum {
+  TT_MOVE_SCORE = 1 << 30,
+  CAPTURE_SCORE = 1 << 24,
+  KILLER_SCORE = 1 << 22,
+  COUNTER_SCORE = 1 << 21,
+  MAX_HISTORY = 1 << 14,
+  BAD_CAPTURE_SCORE = -(1 << 20),
+  UNDER_PROMOTE_SCORE = -(1 << 24),
+};
+
+// Move ordering heuristics for one search thread. Nothing here depends on the
+// search itself: a search reports cutoffs through update_quiet_stats, and asks
+// for move scores through score_moves.
+class MoveOrder {
+  std::array<std::array<move_t, 2>, MAX_PLY + 1> m_killers;
+  // Butterfly history of quiet moves, indexed by moving piece and to-square
+  std::array<std::array<int, 120>, 16> m_history;
+  // Refutations, indexed by the previous move's piece and to-square
+  std::array<std::array<move_t, 120>, 16> m_counter_moves;
+
+  move_t counter_move(const Board &board) const noexcept;
+
+public:
+  MoveOrder() noexcept { clear(); }
+  void clear() noexcept;
+
+  inline int history(const Board &board, const move_t move) const noexcept {
+    return m_history[board.piece_at(move_from(move))][move_to(move)];
+  }
+  inline bool is_killer(const move_t move, const int ply) const noexcept {
+    return move == m_killers[ply][0] || move == m_killers[ply][1];
+  }
+
+  // Fill scores in parallel with moves, for use with pick_move
+  void score_moves(const Board &board, const std::vector<move_t> &moves,
+    std::vector<int> &scores, const move_t tt_move, const int ply) const noexcept;
+
+  // best caused a beta cutoff after the quiet moves in tried failed to
+  void update_quiet_stats(const Board &board, const move_t best,
+    const std::vector<move_t> &tried, const int depth, const int ply) noexcept;
+};
+
+// Most valuable victim, least valuable attacker
+int mvv_lva(const Board &board, const move_t move) noexcept;
+
+// Quiet moves neither capture nor promote
+constexpr inline bool move_is_quiet(const move_t move) {
+  return !move_captured(move) && !move_promoted(move);
+}
+
+// Swaps the best scoring move in [idx, end) into idx and returns it. A partial
+// selection sort is cheaper than sorting, as most nodes cut off early.
+inline move_t pick_move(std::vector<move_t> &moves, std::vector<int> &scores,
+  const size_t idx) noexcept {
+  ASSERT(idx < moves.size() && moves.size() == scores.size());
+  size_t best = idx;
+  for (size_t cur = idx + 1; cur < moves.size(); ++cur)
+    if (scores[cur] > scores[best])
+      best = cur;
+  std::swap(moves[idx], moves[best]);
+  std::swap(scores[idx], scores[best]);
+  return moves[idx];
+}
+
+#endif /* end of include guard: MOVE_ORDER_H */
@@ -0,0 +1,247 @@
+
+#include "nnue.hpp"
+#include "board.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace nnue {
+
+static std::unique_ptr<network_t> loaded_network;
+const network_t *active_network = nullptr;
+
+// File layout: a header of six little-endian uint32s (magic, version and the
+// four layer sizes), then the arrays of network_t in declaration order
+enum : uint32_t { FILE_MAGIC = 0x45554E4E, FILE_VERSION = 1 };
+
+// Feature row for each piece, kings are not features
+constexpr int feature_type[16] = {
+  4, 3, 0, -1, 2, 1, -1, -1,
+  4, 3, 0, -1, 2, 1, -1, -1,
+};
+
+int feature_index(const int perspective, const piece_t piece, const square_t sq,
+  const square_t king_sq) noexcept {
+  ASSERT(valid_piece(piece) && !is_king(piece));
+  // Black sees the board upside down, so both sides share the weights
+  const int flip = (perspective == WHITE) ? 0 : 56;
+  const int type = feature_type[piece] + ((get_side(piece) == perspective) ? 0 : 5);
+  return ((get_square_64(king_sq) ^ flip) * 10 + type) * 64 + (get_square_64(sq) ^ flip);
+}
+
+// Portable kernels, always compiled so the SIMD ones can be checked against them
+struct scalar_kernels {
+  static inline void add_row(int16_t *acc, const int16_t *row) noexcept {
+    for (int idx = 0; idx < L1_SIZE; ++idx)
+      acc[idx] += row[idx];
+  }
+  static inline void sub_row(int16_t *acc, const int16_t *row) noexcept {
+    for (int idx = 0; idx < L1_SIZE; ++idx)
+      acc[idx] -= row[idx];
+  }
+  static inline void add_sub_row(int16_t *acc, const int16_t *add, const int16_t *sub) noexcept {
+    for (int idx = 0; idx < L1_SIZE; ++idx)
+      acc[idx] += add[idx] - sub[idx];
+  }
+  static inline void activate(const int16_t *acc, uint8_t *out) noexcept {
+    for (int idx = 0; idx < L1_SIZE; ++idx)
+      out[idx] = std::clamp<int>(acc[idx], 0, ACTIVATION_MAX);
+  }
+  static inline int32_t dot(const uint8_t *in, const int8_t *weights, const int size) noexcept {
+    int32_t sum = 0;
+    for (int idx = 0; idx < size; ++idx)
+      sum += in[idx] * weights[idx];
+    return sum;
+  }
+};
+
+#ifdef __AVX2__
+struct avx2_kernels {
+  static inline void add_row(int16_t *acc, const int16_t *row) noexcept {
+    for (int idx = 0; idx < L1_SIZE; idx += 16) {
+      __m256i *const dst = reinterpret_cast<__m256i *>(acc + idx);
+      const __m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + idx));
+      _mm256_store_si256(dst, _mm256_add_epi16(_mm256_load_si256(dst), src));
+    }
+  }
+  static inline void sub_row(int16_t *acc, const int16_t *row) noexcept {
+    for (int idx = 0; idx < L1_SIZE; idx += 16) {
+      __m256i *const dst = reinterpret_cast<__m256i *>(acc + idx);
+      const __m256i src = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row + idx));
+      _mm256_store_si256(dst, _mm256_sub_epi16(_mm256_load_si256(dst), src));
+    }
+  }
+  static inline void add_sub_row(int16_t *acc, const int16_t *add, const int16_t *sub) noexcept {
+    for (int idx = 0; idx < L1_SIZE; idx += 16) {
+      __m256i *const dst = reinterpret_cast<__m256i *>(acc + idx);
+      const __m256i plus = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(add + idx));
+      const __m256i minus = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(sub + idx));
+      _mm256_store_si256(dst, _mm256_sub_epi16(_mm256_add_epi16(_mm256_load_si256(dst), plus), minus));
+    }
+  }
+  static inline void activate(const int16_t *acc, uint8_t *out) noexcept {
+    for (int idx = 0; idx < L1_SIZE; idx += 32) {
+      const __m256i lo = _mm256_load_si256(reinterpret_cast<const __m256i *>(acc + idx));
+      const __m256i hi = _mm256_load_si256(reinterpret_cast<const __m256i *>(acc + idx + 16));
+      // Saturating pack to [-128, 127] works within 128-bit lanes, the
+      // permute puts the 64-bit quarters back in order
+      const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(lo, hi), 0xD8);
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + idx),
+        _mm256_max_epi8(packed, _mm256_setzero_si256()));
+    }
+  }
+  static inline int32_t dot(const uint8_t *in, const int8_t *weights, const int size) noexcept {
+    // Activations are at most 127, so the pairwise int16 sums cannot saturate
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (int idx = 0; idx < size; idx += 32) {
+      const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + idx));
+      const __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(weights + idx));
+      sum = _mm256_add_epi32(sum, _mm256_madd_epi16(_mm256_maddubs_epi16(x, w), ones));
+    }
+    const __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    const __m128i quarter = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+    return _mm_cvtsi128_si32(_mm_add_epi32(quarter, _mm_shuffle_epi32(quarter, 0xB1)));
+  }
+};
+using kernels = avx2_kernels;
+#else
+using kernels = scalar_kernels;
+#endif
+
+template <typename Kernels>
+static inline void dense(const uint8_t *in, const int in_size, const int8_t *weights,
+  const int32_t *bias, uint8_t *out, const int out_size) noexcept {
+  for (int idx = 0; idx < out_size; ++idx) {
+    const int32_t sum = bias[idx] + Kernels::dot(in, weights + idx * in_size, in_size);
+    out[idx] = std::clamp<int32_t>(sum >> WEIGHT_SHIFT, 0, ACTIVATION_MAX);
+  }
+}
+
+template <typename Kernels>
+static int forward(const network_t &net, const accumulator_t &acc, const int side) noexcept {
+  alignas(32) uint8_t input[2 * L1_SIZE];
+  alignas(32) uint8_t hidden2[L2_SIZE];
+  alignas(32) uint8_t hidden3[L3_SIZE];
+  Kernels::activate(acc.values[side].data(), input);
+  Kernels::activate(acc.values[!side].data(), input + L1_SIZE);
+  dense<Kernels>(input, 2 * L1_SIZE, net.l2_weights.data(), net.l2_bias.data(), hidden2, L2_SIZE);
+  dense<Kernels>(hidden2, L2_SIZE, net.l3_weights.data(), net.l3_bias.data(), hidden3, L3_SIZE);
+  return (net.out_bias + Kernels::dot(hidden3, net.out_weights.data(), L3_SIZE)) / OUTPUT_SCALE;
+}
+
+void add_piece(accumulator_t &acc, const piece_t piece, const square_t sq,
+  const square_t white_king, const square_t black_king) noexcept {
+  const int16_t *const weights = active_network->ft_weights.data();
+  kernels::add_row(acc.values[WHITE].data(),
+    weights + feature_index(WHITE, piece, sq, white_king) * L1_SIZE);
+  kernels::add_row(acc.values[BLACK].data(),
+    weights + feature_index(BLACK, piece, sq, black_king) * L1_SIZE);
+}
+
+void remove_piece(accumulator_t &acc, const piece_t piece, const square_t sq,
+  const square_t white_king, const square_t black_king) noexcept {
+  const int16_t *const weights = active_network->ft_weights.data();
+  kernels::sub_row(acc.values[WHITE].data(),
+    weights + feature_index(WHITE, piece, sq, white_king) * L1_SIZE);
+  kernels::sub_row(acc.values[BLACK].data(),
+    weights + feature_index(BLACK, piece, sq, black_king) * L1_SIZE);
+}
+
+void move_piece(accumulator_t &acc, const piece_t piece, const square_t from,
+  const square_t to, const square_t white_king, const square_t black_king) noexcept {
+  const int16_t *const weights = active_network->ft_weights.data();
+  kernels::add_sub_row(acc.values[WHITE].data(),
+    weights + feature_index(WHITE, piece, to, white_king) * L1_SIZE,
+    weights + feature_index(WHITE, piece, from, white_king) * L1_SIZE);
+  kernels::add_sub_row(acc.values[BLACK].data(),
+    weights + feature_index(BLACK, piece, to, black_king) * L1_SIZE,
+    weights + feature_index(BLACK, piece, from, black_king) * L1_SIZE);
+}
+
+void refresh(accumulator_t &acc, const Board &board, const int perspective) noexcept {
+  ASSERT(enabled());
+  const network_t &net = *active_network;
+  const square_t king_sq = board.m_positions[(perspective == WHITE) ? WHITE_KING : BLACK_KING][0];
+  std::copy(net.ft_bias.begin(), net.ft_bias.end(), acc.values[perspective].begin());
+  for (piece_t piece = 0; piece < 16; ++piece) {
+    if (feature_type[piece] < 0)
+      continue;
+    for (unsigned idx = 0; idx < board.m_num_pieces[piece]; ++idx) {
+      const int feature = feature_index(perspective, piece, board.m_positions[piece][idx], king_sq);
+      kernels::add_row(acc.values[perspective].data(), net.ft_weights.data() + feature * L1_SIZE);
+    }
+  }
+}
+
+int evaluate(const Board &board) noexcept {
+  ASSERT(enabled());
+  return forward<kernels>(*active_network, board.m_accumulator, board.m_next_move_colour);
+}
+
+int evaluate_scalar(const Board &board) noexcept {
+  ASSERT(enabled());
+  return forward<scalar_kernels>(*active_network, board.m_accumulator, board.m_next_move_colour);
+}
+
+template <typename T>
+static inline bool read_array(std::istream &in, T *data, const size_t count) noexcept {
+  return bool(in.read(reinterpret_cast<char *>(data), count * sizeof(T)));
+}
+
+template <typename T>
+static inline bool write_array(std::ostream &out, const T *data, const size_t count) noexcept {
+  return bool(out.write(reinterpret_cast<const char *>(data), count * sizeof(T)));
+}
+
+bool load(const std::string &path) noexcept {
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    return false;
+  const uint32_t expected[6] = {FILE_MAGIC, FILE_VERSION, NUM_FEATURES, L1_SIZE, L2_SIZE, L3_SIZE};
+  uint32_t header[6];
+  if (!read_array(in, header, 6) || !std::equal(header, header + 6, expected))
+    return false;
+
+  auto net = std::make_unique<network_t>();
+  const bool ok = read_array(in, net->ft_bias.data(), net->ft_bias.size())
+    && read_array(in, net->ft_weights.data(), net->ft_weights.size())
+    && read_array(in, net->l2_bias.data(), net->l2_bias.size())
+    && read_array(in, net->l2_weights.data(), net->l2_weights.size())
+    && read_array(in, net->l3_bias.data(), net->l3_bias.size())
+    && read_array(in, net->l3_weights.data(), net->l3_weights.size())
+    && read_array(in, &net->out_bias, 1)
+    && read_array(in, net->out_weights.data(), net->out_weights.size());
+  if (!ok || in.peek() != std::ifstream::traits_type::eof())
+    return false;
+  loaded_network = std::move(net);
+  active_network = loaded_network.get();
+  return true;
+}
+
+bool save(const network_t &net, const std::string &path) noexcept {
+  std::ofstream out(path, std::ios::binary);
+  const uint32_t header[6] = {FILE_MAGIC, FILE_VERSION, NUM_FEATURES, L1_SIZE, L2_SIZE, L3_SIZE};
+  return out
+    && write_array(out, header, 6)
+    && write_array(out, net.ft_bias.data(), net.ft_bias.size())
+    && write_array(out, net.ft_weights.data(), net.ft_weights.size())
+    && write_array(out, net.l2_bias.data(), net.l2_bias.size())
+    && write_array(out, net.l2_weights.data(), net.l2_weights.size())
+    && write_array(out, net.l3_bias.data(), net.l3_bias.size())
+    && write_array(out, net.l3_weights.data(), net.l3_weights.size())
+    && write_array(out, &net.out_bias, 1)
+    && write_array(out, net.out_weights.data(), net.out_weights.size());
+}
+
+void unload() noexcept {
+  active_network = nullptr;
+  loaded_network.reset();
+}
+
+} // namespace nnue
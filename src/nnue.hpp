@@ -0,0 +1,87 @@
+
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "defs.hpp"
+#include "piece.hpp"
+#include "square.hpp"
+
+struct Board;
+
+/*
+NETWORK:
+- features - 64 own king squares x 10 non-king pieces x 64 squares, seen from
+             each side with the board flipped for black (HalfKP)
+- L1       - 2 x 128, int16 accumulators, one per perspective, side to move first
+- L2       - 256 -> 32, int8 weights, clipped ReLU
+- L3       - 32 -> 32, int8 weights, clipped ReLU
+- output   - 32 -> 1, in centipawns after dividing by OUTPUT_SCALE
+
+Only the first layer is updated incrementally. Every non-king piece is a
+feature, so adding or removing one touches one row of the feature weights per
+perspective; a king move changes every feature of its own perspective and
+refreshes it from scratch.
+*/
+
+namespace nnue {
+
+enum { NUM_FEATURES = 64 * 10 * 64 };
+enum { L1_SIZE = 128, L2_SIZE = 32, L3_SIZE = 32 };
+// Activations are clipped to [0, ACTIVATION_MAX], and dense layer sums are
+// shifted down by WEIGHT_SHIFT before clipping
+enum { ACTIVATION_MAX = 127, WEIGHT_SHIFT = 6, OUTPUT_SCALE = 16 };
+
+struct alignas(32) accumulator_t {
+  std::array<std::array<int16_t, L1_SIZE>, 2> values;
+};
+
+struct network_t {
+  std::array<int16_t, L1_SIZE> ft_bias;
+  std::vector<int16_t> ft_weights; // [NUM_FEATURES][L1_SIZE]
+  std::array<int32_t, L2_SIZE> l2_bias;
+  std::array<int8_t, L2_SIZE * 2 * L1_SIZE> l2_weights; // [L2_SIZE][2 * L1_SIZE]
+  std::array<int32_t, L3_SIZE> l3_bias;
+  std::array<int8_t, L3_SIZE * L2_SIZE> l3_weights; // [L3_SIZE][L2_SIZE]
+  int32_t out_bias;
+  std::array<int8_t, L3_SIZE> out_weights;
+
+  network_t() noexcept: ft_weights(size_t(NUM_FEATURES) * L1_SIZE) {}
+};
+
+// The network used by evaluate, or nullptr for the hand-written evaluation.
+// Boards only keep their accumulators up to date while a network is loaded.
+extern const network_t *active_network;
+inline bool enabled() noexcept { return active_network != nullptr; }
+
+// Loads weights from a file written by save. On failure the active network is
+// left unchanged. Neither may be called while boards are being searched.
+bool load(const std::string &path) noexcept;
+bool save(const network_t &network, const std::string &path) noexcept;
+void unload() noexcept;
+
+// Row of the feature weights for piece on sq, from perspective's point of view
+int feature_index(const int perspective, const piece_t piece, const square_t sq,
+  const square_t king_sq) noexcept;
+
+// Incremental updates, for the Board piece helpers. Kings are not features.
+void add_piece(accumulator_t &acc, const piece_t piece, const square_t sq,
+  const square_t white_king, const square_t black_king) noexcept;
+void remove_piece(accumulator_t &acc, const piece_t piece, const square_t sq,
+  const square_t white_king, const square_t black_king) noexcept;
+void move_piece(accumulator_t &acc, const piece_t piece, const square_t from,
+  const square_t to, const square_t white_king, const square_t black_king) noexcept;
+void refresh(accumulator_t &acc, const Board &board, const int perspective) noexcept;
+
+// Evaluation in centipawns from the side to move's point of view
+int evaluate(const Board &board) noexcept;
+// Same, always through the portable kernels, to check the SIMD ones against
+int evaluate_scalar(const Board &board) noexcept;
+
+} // namespace nnue
+
+#endif /* end of include guard: NNUE_H */
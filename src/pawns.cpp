@@ -0,0 +1,134 @@
+
+#include "pawns.hpp"
+
+#include <algorithm>
+
+// Pawn structure terms, as {mg, eg} in centipawns
+constexpr psq_t DOUBLED_PENALTY = {10, 20};
+constexpr psq_t ISOLATED_PENALTY = {10, 15};
+// Indexed by rank relative to the pawn's side
+constexpr psq_t passed_bonus[8] = {
+  {0, 0}, {0, 10}, {5, 15}, {10, 30}, {20, 50}, {35, 80}, {60, 120}, {0, 0},
+};
+// Shelter for each of the three files around the king: a pawn on the second
+// or third rank, or none at all in front of the king
+enum { SHIELD_NEAR = 15, SHIELD_FAR = 8, SHIELD_OPEN = -15 };
+
+void evaluate_pawns(const Board &board, pawn_entry_t &entry) noexcept {
+  entry.key = board.m_pawn_hash;
+  entry.score = psq_t();
+  entry.passed = {0, 0};
+
+  // Most and least advanced pawn on each file, as relative ranks, with 0 as
+  // "no pawn" for the most advanced and 8 for the least advanced
+  std::array<std::array<int, 8>, 2> front, back, count;
+  for (const int side : {WHITE, BLACK}) {
+    front[side].fill(0);
+    back[side].fill(8);
+    count[side].fill(0);
+    const piece_t pawn = (side == WHITE) ? WHITE_PAWN : BLACK_PAWN;
+    for (unsigned idx = 0; idx < board.m_num_pieces[pawn]; ++idx) {
+      const square_t sq = board.m_positions[pawn][idx];
+      const int file = get_square_col(sq);
+      const int rank = (side == WHITE) ? get_square_row(sq) : 7 - get_square_row(sq);
+      front[side][file] = std::max(front[side][file], rank);
+      back[side][file] = std::min(back[side][file], rank);
+      count[side][file]++;
+    }
+  }
+
+  for (const int side : {WHITE, BLACK}) {
+    psq_t score;
+    const piece_t pawn = (side == WHITE) ? WHITE_PAWN : BLACK_PAWN;
+    for (int file = 0; file < 8; ++file) {
+      if (count[side][file] == 0)
+        continue;
+      if (count[side][file] > 1) {
+        score.mg -= DOUBLED_PENALTY.mg * (count[side][file] - 1);
+        score.eg -= DOUBLED_PENALTY.eg * (count[side][file] - 1);
+      }
+      const bool left = file > 0 && count[side][file - 1] > 0;
+      const bool right = file < 7 && count[side][file + 1] > 0;
+      if (!left && !right) {
+        score.mg -= ISOLATED_PENALTY.mg * count[side][file];
+        score.eg -= ISOLATED_PENALTY.eg * count[side][file];
+      }
+    }
+    for (unsigned idx = 0; idx < board.m_num_pieces[pawn]; ++idx) {
+      const square_t sq = board.m_positions[pawn][idx];
+      const int file = get_square_col(sq);
+      const int rank = (side == WHITE) ? get_square_row(sq) : 7 - get_square_row(sq);
+      // Passed: no enemy pawn ahead on this or an adjacent file. Enemy ranks
+      // are flipped into this side's frame, so "ahead" is a larger rank.
+      bool passed = rank == front[side][file];
+      for (int other = std::max(file - 1, 0); other <= std::min(file + 1, 7) && passed; ++other)
+        if (back[!side][other] != 8 && 7 - back[!side][other] > rank)
+          passed = false;
+      if (passed) {
+        score += passed_bonus[rank];
+        entry.passed[side] |= 1u << file;
+      }
+    }
+    if (side == WHITE)
+      entry.score += score;
+    else
+      entry.score -= score;
+  }
+
+  for (const int side : {WHITE, BLACK}) {
+    for (int king_file = 0; king_file < 8; ++king_file) {
+      int shield = 0;
+      // The edge files count their inner neighbour twice, rather than
+      // treating the board edge as an open file
+      const int centre = std::clamp(king_file, 1, 6);
+      for (int file = centre - 1; file <= centre + 1; ++file) {
+        const int nearest = back[side][file];
+        shield += (nearest == 1) ? SHIELD_NEAR : (nearest == 2) ? SHIELD_FAR
+          : (count[side][file] == 0) ? SHIELD_OPEN : 0;
+      }
+      entry.shield[side][king_file] = shield;
+    }
+  }
+}
+
+PawnTable::PawnTable(const size_t num_entries) noexcept {
+  size_t size = 1;
+  while (2 * size <= num_entries)
+    size *= 2;
+  m_entries.resize(size);
+  clear();
+}
+
+void PawnTable::clear() noexcept {
+  // Every slot starts out as the (correct) entry for a board without pawns,
+  // whose key is zero, rather than needing a separate "empty" marker
+  pawn_entry_t no_pawns;
+  evaluate_pawns(Board("4k3/8/8/8/8/8/8/4K3 w - - 0 1"), no_pawns);
+  std::fill(m_entries.begin(), m_entries.end(), no_pawns);
+  m_hits = m_probes = 0;
+}
+
+const pawn_entry_t &PawnTable::probe(const Board &board) noexcept {
+  const hash_t key = board.pawn_hash();
+  pawn_entry_t &entry = m_entries[key & (m_entries.size() - 1)];
+  m_probes++;
+  if (entry.key == key) {
+    m_hits++;
+    return entry;
+  }
+  evaluate_pawns(board, entry);
+  return entry;
+}
+
+int king_shelter(const Board &board, const pawn_entry_t &entry) noexcept {
+  int result = 0;
+  for (const int side : {WHITE, BLACK}) {
+    const square_t king = board.m_positions[(side == WHITE) ? WHITE_KING : BLACK_KING][0];
+    const int rank = (side == WHITE) ? get_square_row(king) : 7 - get_square_row(king);
+    if (rank <= 1) {
+      const int shield = entry.shield[side][get_square_col(king)];
+      result += (side == WHITE) ? shield : -shield;
+    }
+  }
+  return result;
+}
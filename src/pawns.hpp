@@ -0,0 +1,51 @@
+
+#ifndef PAWNS_H
+#define PAWNS_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "defs.hpp"
+#include "board.hpp"
+#include "psqt.hpp"
+
+/*
+PAWN ENTRY:
+- key    - pawn Zobrist key of the position it was computed for
+- score  - doubled, isolated and passed pawn terms, from white's point of view
+- shield - king shelter by king file, for a king on its first two ranks
+- passed - files holding a passed pawn, one bit per file
+*/
+struct pawn_entry_t {
+  hash_t key;
+  psq_t score;
+  std::array<std::array<int16_t, 8>, 2> shield;
+  std::array<uint8_t, 2> passed;
+};
+
+// Computes the entry for the pawns on board from scratch
+void evaluate_pawns(const Board &board, pawn_entry_t &entry) noexcept;
+
+// Pawn structure only changes on pawn moves and captures of pawns, so most
+// probes hit. One table per search thread, so there is no locking.
+class PawnTable {
+  std::vector<pawn_entry_t> m_entries;
+  size_t m_hits = 0, m_probes = 0;
+
+public:
+  enum { DEFAULT_ENTRIES = 1 << 14 };
+
+  // num_entries is rounded down to a power of two
+  PawnTable(size_t num_entries = DEFAULT_ENTRIES) noexcept;
+  void clear() noexcept;
+
+  const pawn_entry_t &probe(const Board &board) noexcept;
+  inline size_t hits() const noexcept { return m_hits; }
+  inline size_t probes() const noexcept { return m_probes; }
+};
+
+// The shelter term of entry for the kings on board, from white's point of view
+int king_shelter(const Board &board, const pawn_entry_t &entry) noexcept;
+
+#endif /* end of include guard: PAWNS_H */
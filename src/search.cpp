@@ -0,0 +1,647 @@
+
+#include "search.hpp"
+#include "eval.hpp"
+#include "move.hpp"
+#include "move_order.hpp"
+#include "stats.hpp"
+#include "tb.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <thread>
+
+struct search_param_t {
+  const char *name;
+  int search_params_t::*member;
+  // A minimum depth of MAX_PLY + 1 turns a technique off
+  int min, max;
+};
+
+constexpr search_param_t search_param_list[] = {
+  {"nmp_min_depth", &search_params_t::nmp_min_depth, 1, MAX_PLY + 1},
+  {"nmp_reduction", &search_params_t::nmp_reduction, 0, MAX_PLY},
+  {"nmp_depth_divisor", &search_params_t::nmp_depth_divisor, 1, MAX_PLY},
+  {"nmp_verify_depth", &search_params_t::nmp_verify_depth, 1, MAX_PLY + 1},
+  {"lmr_min_depth", &search_params_t::lmr_min_depth, 1, MAX_PLY + 1},
+  {"lmr_min_moves", &search_params_t::lmr_min_moves, 0, 64},
+  {"lmr_base", &search_params_t::lmr_base, 0, 1000},
+  {"lmr_divisor", &search_params_t::lmr_divisor, 1, 1000},
+  {"rfp_max_depth", &search_params_t::rfp_max_depth, 0, MAX_PLY},
+  {"rfp_margin", &search_params_t::rfp_margin, 0, 1000},
+  {"futility_max_depth", &search_params_t::futility_max_depth, 0, MAX_PLY},
+  {"futility_base", &search_params_t::futility_base, 0, 2000},
+  {"futility_margin", &search_params_t::futility_margin, 0, 1000},
+  {"razor_max_depth", &search_params_t::razor_max_depth, 0, MAX_PLY},
+  {"razor_base", &search_params_t::razor_base, 0, 2000},
+  {"razor_margin", &search_params_t::razor_margin, 0, 1000},
+  {"lmp_max_depth", &search_params_t::lmp_max_depth, 0, MAX_PLY},
+  {"lmp_base", &search_params_t::lmp_base, 0, 256},
+  {"delta_margin", &search_params_t::delta_margin, 0, 2000},
+};
+
+bool search_params_t::set(const std::string &name, const int value) noexcept {
+  for (const search_param_t &param : search_param_list) {
+    if (name == param.name) {
+      this->*param.member = std::clamp(value, param.min, param.max);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool search_params_t::get(const std::string &name, int &value) const noexcept {
+  for (const search_param_t &param : search_param_list) {
+    if (name == param.name) {
+      value = this->*param.member;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool search_params_t::range(const std::string &name, int &min, int &max) noexcept {
+  for (const search_param_t &param : search_param_list) {
+    if (name == param.name) {
+      min = param.min;
+      max = param.max;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::vector<std::string> search_params_t::names() noexcept {
+  std::vector<std::string> result;
+  for (const search_param_t &param : search_param_list)
+    result.push_back(param.name);
+  return result;
+}
+
+// Mate scores are stored relative to the node rather than the root, so that
+// a transposition reached at a different ply reports the right distance
+static inline int score_to_tt(const int score, const int ply) noexcept {
+  if (score >= MATE_IN_MAX_PLY) return score + ply;
+  if (score <= -MATE_IN_MAX_PLY) return score - ply;
+  return score;
+}
+
+static inline int score_from_tt(const int score, const int ply) noexcept {
+  if (score >= MATE_IN_MAX_PLY) return score - ply;
+  if (score <= -MATE_IN_MAX_PLY) return score + ply;
+  return score;
+}
+
+// Kept by the Searcher from one search to the next, so that the move ordering
+// history and pawn table stay warm; start() resets the rest
+struct search_thread_t {
+  Searcher &searcher;
+  const unsigned id;
+  Board board;
+  // Only written by the owning thread, read by the others for node limits
+  std::atomic<size_t> nodes{0};
+  int seldepth = 0;
+  // Null moves are not tried before this ply while verifying a null cutoff
+  int nmp_min_ply = 0;
+  // Root moves already reported as better lines in this iteration
+  std::vector<move_t> root_excluded;
+  search_info_t result;
+  MoveOrder ordering;
+  PawnTable pawns;
+
+  // Triangular principal variation table
+  std::array<std::array<move_t, MAX_PLY>, MAX_PLY> pv;
+  std::array<int, MAX_PLY> pv_length;
+
+  search_thread_t(Searcher &_searcher, const unsigned _id) noexcept:
+    searcher(_searcher), id(_id) {}
+
+  void start(const Board &_board) noexcept {
+    board = _board;
+    // The copy does not need the caller's pseudo_moves cache
+    board.m_move_cache.clear();
+    // The caller's board may predate the network
+    board.refresh_accumulator();
+    nodes.store(0, std::memory_order_relaxed);
+    seldepth = 0;
+    nmp_min_ply = 0;
+    root_excluded.clear();
+    result = search_info_t();
+    pv_length.fill(0);
+  }
+
+  inline bool is_main() const noexcept { return id == 0; }
+  void iterate(const info_callback_t &on_iteration,
+    const std::chrono::steady_clock::time_point start);
+  // Counts a node and polls the limits, returns whether the search stopped
+  bool visit_node(const int ply) noexcept;
+  int negamax(int alpha, int beta, int depth, const int ply);
+  int qsearch(int alpha, int beta, const int ply, const int qply);
+};
+
+// Quiet checks are only tried on the first quiescence ply, deeper checks
+// rarely pay for their evasions
+enum { QSEARCH_CHECK_PLIES = 1 };
+
+void search_thread_t::iterate(const info_callback_t &on_iteration,
+  const std::chrono::steady_clock::time_point start) {
+  // Helpers with odd ids run one ply ahead of the main thread
+  const int first_depth = 1 + (id & 1);
+  for (int depth = first_depth; depth <= searcher.m_limits.depth; ++depth) {
+    TRACE_SCOPE(PHASE, "iteration", depth);
+    seldepth = 0;
+    // Each further line searches the root without the moves already found
+    std::vector<pv_line_t> lines;
+    root_excluded.clear();
+    for (int pv_idx = 0; pv_idx < std::max(searcher.m_limits.multi_pv, 1); ++pv_idx) {
+      const int score = negamax(-INF_SCORE, INF_SCORE, depth, 0);
+      if ((searcher.stopped() && pv_idx > 0) || (pv_idx > 0 && pv_length[0] == 0))
+        break;
+      lines.push_back({score, std::vector<move_t>(pv[0].begin(), pv[0].begin() + pv_length[0])});
+      if (searcher.stopped() || pv_length[0] == 0)
+        break;
+      root_excluded.push_back(pv[0][0]);
+    }
+    // An interrupted iteration is only trusted if it is all we have
+    if (searcher.stopped() && !result.pv.empty())
+      break;
+
+    std::stable_sort(lines.begin(), lines.end(), [](const pv_line_t &a, const pv_line_t &b) {
+      return a.score > b.score;
+    });
+    const int score = lines[0].score;
+    result.depth = depth;
+    result.seldepth = seldepth;
+    result.score = score;
+    result.pv = lines[0].pv;
+    result.lines = std::move(lines);
+    if (is_main()) {
+      result.nodes = searcher.nodes();
+      result.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+      if (on_iteration)
+        on_iteration(result);
+      // Past the soft deadline the next iteration would likely not finish.
+      // A pondering search keeps going, the deadline is checked after
+      // ponderhit.
+      const bool more_time = searcher.m_time.should_continue(result.best_move(), score,
+        searcher.elapsed_ms());
+      if (!more_time && !searcher.m_pondering.load(std::memory_order_relaxed))
+        break;
+    }
+    if (searcher.stopped())
+      break;
+  }
+}
+
+static inline bool has_non_pawn_material(const Board &board) noexcept {
+  const piece_t base = (board.m_next_move_colour == WHITE) ? 0 : 8;
+  return board.m_num_pieces[base + WHITE_QUEEN] + board.m_num_pieces[base + WHITE_ROOK]
+    + board.m_num_pieces[base + WHITE_BISHOP] + board.m_num_pieces[base + WHITE_KNIGHT] != 0;
+}
+
+bool search_thread_t::visit_node(const int ply) noexcept {
+  const size_t node_count = nodes.load(std::memory_order_relaxed) + 1;
+  nodes.store(node_count, std::memory_order_relaxed);
+  static_assert((CHECK_NODES & (CHECK_NODES - 1)) == 0, "CHECK_NODES must be a power of two");
+  if (is_main() && (node_count & (CHECK_NODES - 1)) == 0)
+    searcher.check_limits();
+  seldepth = std::max(seldepth, ply);
+  return searcher.stopped();
+}
+
+// Mates too far away for mate scores still score above any evaluation
+static inline int tb_score(const tb::probe_result_t &result, const int ply) noexcept {
+  if (result.wdl == tb::TB_DRAW)
+    return DRAW_SCORE;
+  const int score = (ply + result.dtm < MAX_PLY) ? mate_in(ply + result.dtm)
+    : MATE_IN_MAX_PLY - 1 - result.dtm;
+  return (result.wdl == tb::TB_WIN) ? score : -score;
+}
+
+int search_thread_t::negamax(int alpha, int beta, int depth, const int ply) {
+  ASSERT(-INF_SCORE <= alpha && alpha < beta && beta <= INF_SCORE);
+  const bool root_node = ply == 0;
+  const bool pv_node = beta - alpha > 1;
+  if (depth <= 0)
+    return qsearch(alpha, beta, ply, 0);
+
+  pv_length[ply] = ply;
+  if (visit_node(ply) && !root_node)
+    return 0;
+  STAT_INC(STAT_NODES);
+
+  if (!root_node) {
+    // A single repetition is enough in the search: if it was good to repeat
+    // once, it is good to repeat again
+    if (board.is_drawn() || board.is_repetition(1))
+      return DRAW_SCORE;
+    if (ply >= MAX_PLY - 1)
+      return evaluate(board, &pawns);
+
+    // Mate distance pruning: no line from here can beat a shorter mate
+    alpha = std::max(alpha, mated_in(ply));
+    beta = std::min(beta, mate_in(ply + 1));
+    if (alpha >= beta)
+      return alpha;
+
+    // Tablebase positions are scored exactly
+    tb::probe_result_t tb_result;
+    if (tb::probe(board, tb_result))
+      return tb_score(tb_result, ply);
+  }
+
+  // Transposition table lookup
+  const hash_t hash = board.hash();
+  bool tt_hit = false;
+  tt_entry_t *const tt_entry = searcher.m_tt.probe(hash, tt_hit);
+  STAT_INC(STAT_TT_PROBES);
+  STAT_INC_IF(tt_hit, STAT_TT_HITS);
+  const move_t tt_move = tt_hit ? tt_entry->move() : NULL_MOVE;
+  if (tt_hit && !pv_node && tt_entry->depth() >= depth) {
+    const int tt_score = score_from_tt(tt_entry->score(), ply);
+    const Bound bound = tt_entry->bound();
+    if (bound == BOUND_EXACT
+      || (bound == BOUND_LOWER && tt_score >= beta)
+      || (bound == BOUND_UPPER && tt_score <= alpha)) {
+      STAT_INC(STAT_TT_CUTOFFS);
+      return tt_score;
+    }
+  }
+
+  const search_params_t &params = searcher.m_params;
+  const bool in_check = board.king_in_check();
+  if (in_check)
+    depth++;
+  const int static_eval = in_check ? -INF_SCORE
+    : tt_hit ? tt_entry->eval() : evaluate(board, &pawns);
+
+  if (!pv_node && !in_check && !is_mate_score(beta)) {
+    // Reverse futility: far enough above beta that no move will drop below it
+    if (depth <= params.rfp_max_depth && static_eval - params.rfp_margin * depth >= beta)
+      return static_eval;
+
+    // Razoring: so far below alpha that only captures could help
+    if (depth <= params.razor_max_depth
+      && static_eval + params.razor_base + params.razor_margin * depth <= alpha) {
+      const int score = qsearch(alpha, alpha + 1, ply, 0);
+      if (score <= alpha)
+        return score;
+    }
+  }
+
+  // Null move pruning: if the opponent still cannot reach beta after a free
+  // move, a real move almost certainly fails high too. Zugzwang breaks this,
+  // so it is skipped when the side to move has only pawns, and never done
+  // twice in a row.
+  const bool after_null = !board.m_history.empty() && board.m_history.back().move == NULL_MOVE;
+  if (!pv_node && !in_check && !after_null && depth >= params.nmp_min_depth
+    && ply >= nmp_min_ply && !is_mate_score(beta) && has_non_pawn_material(board)
+    && static_eval >= beta) {
+    const int null_depth = depth - 1 - params.nmp_reduction
+      - depth / std::max(params.nmp_depth_divisor, 1);
+    board.make_null_move();
+    int score = -negamax(-beta, -beta + 1, null_depth, ply + 1);
+    board.unmake_null_move();
+    if (searcher.stopped())
+      return 0;
+    if (score >= beta) {
+      // Mates found after passing are not proven
+      if (is_mate_score(score))
+        score = beta;
+      if (depth < params.nmp_verify_depth)
+        return score;
+      // Verifications nest, so the outer one's limit is restored afterwards
+      const int saved_min_ply = nmp_min_ply;
+      nmp_min_ply = ply + 3 * null_depth / 4;
+      const int verified = negamax(beta - 1, beta, null_depth, ply);
+      nmp_min_ply = saved_min_ply;
+      pv_length[ply] = ply;
+      if (verified >= beta)
+        return score;
+    }
+  }
+
+  // Moves are generated without legality checks, so a table move (possibly
+  // from a key collision or a torn write) is only used if it was generated
+  std::vector<move_t> moves = board.generate_moves();
+  std::vector<int> scores;
+  ordering.score_moves(board, moves, scores, tt_move, ply);
+
+  // Quiet moves late in the list are pruned near the leaves once some move
+  // has avoided being mated
+  const bool futile = !in_check && depth <= params.futility_max_depth
+    && static_eval + params.futility_base + params.futility_margin * depth <= alpha;
+  const int lmp_count = (!in_check && depth <= params.lmp_max_depth)
+    ? params.lmp_base + depth * depth : -1;
+
+  const int alpha_orig = alpha;
+  int best_score = -INF_SCORE;
+  move_t best_move = NULL_MOVE;
+  unsigned legal_moves = 0;
+  int quiets_seen = 0;
+  std::vector<move_t> quiets_tried;
+  for (size_t idx = 0; idx < moves.size(); ++idx) {
+    const move_t move = pick_move(moves, scores, idx);
+    if (root_node && std::find(root_excluded.begin(), root_excluded.end(), move) != root_excluded.end())
+      continue;
+    const bool quiet = move_is_quiet(move);
+    if (quiet)
+      quiets_seen++;
+    if (!root_node && quiet && best_score > -MATE_IN_MAX_PLY && move != tt_move) {
+      if (futile || (lmp_count >= 0 && quiets_seen > lmp_count))
+        continue;
+    }
+
+    if (!board.make_move(move)) {
+      board.unmake_move();
+      continue;
+    }
+    legal_moves++;
+    searcher.m_tt.prefetch(board.hash());
+
+    // Principal variation search: scout later moves with a null window, and
+    // late quiet moves at a reduced depth first
+    int score;
+    if (legal_moves == 1) {
+      score = -negamax(-beta, -alpha, depth - 1, ply + 1);
+    } else {
+      int reduction = 0;
+      if (depth >= params.lmr_min_depth && (int)legal_moves > params.lmr_min_moves
+        && quiet && !in_check && !board.king_in_check()) {
+        reduction = searcher.m_reductions[std::min(depth, (int)MAX_PLY)][std::min(legal_moves, 63u)];
+        reduction -= pv_node + ordering.is_killer(move, ply);
+        // lmr_min_depth may be 1, where depth - 2 is below 0
+        reduction = std::max(0, std::min(reduction, depth - 2));
+      }
+      score = -negamax(-alpha - 1, -alpha, depth - 1 - reduction, ply + 1);
+      if (reduction > 0 && score > alpha)
+        score = -negamax(-alpha - 1, -alpha, depth - 1, ply + 1);
+      if (score > alpha && score < beta)
+        score = -negamax(-beta, -alpha, depth - 1, ply + 1);
+    }
+    board.unmake_move();
+
+    // Results are garbage after a stop, except that the root keeps what it
+    // has completed, and always at least its first move
+    if (searcher.stopped()) {
+      if (!root_node)
+        return 0;
+      if (legal_moves > 1)
+        break;
+    }
+
+    if (score > best_score) {
+      best_score = score;
+      if (score > alpha) {
+        best_move = move;
+        pv[ply][ply] = move;
+        for (int idx = ply + 1; idx < pv_length[ply + 1]; ++idx)
+          pv[ply][idx] = pv[ply + 1][idx];
+        pv_length[ply] = std::max(ply + 1, pv_length[ply + 1]);
+        if (score >= beta) {
+          STAT_INC(STAT_FAIL_HIGHS);
+          STAT_INC_IF(legal_moves == 1, STAT_FAIL_HIGHS_FIRST);
+          if (quiet)
+            ordering.update_quiet_stats(board, move, quiets_tried, depth, ply);
+          break;
+        }
+        alpha = score;
+      }
+    }
+    if (quiet)
+      quiets_tried.push_back(move);
+  }
+
+  // Moves are only pruned after one was searched, so this is mate or stalemate
+  if (legal_moves == 0)
+    return in_check ? mated_in(ply) : DRAW_SCORE;
+  // A root searched without some of its moves is not worth storing
+  if (searcher.stopped() || (root_node && !root_excluded.empty()))
+    return best_score;
+
+  const Bound bound = (best_score >= beta) ? BOUND_LOWER
+    : (best_score > alpha_orig) ? BOUND_EXACT : BOUND_UPPER;
+  tt_entry->save(hash, score_to_tt(best_score, ply), in_check ? evaluate(board, &pawns) : static_eval, best_move,
+    depth, bound, searcher.m_tt.generation());
+  return best_score;
+}
+
+// Resolves captures (and promotions, and a few checks) until the position is
+// quiet, so that the static evaluation is not taken in the middle of an exchange
+int search_thread_t::qsearch(int alpha, int beta, const int ply, const int qply) {
+  ASSERT(-INF_SCORE <= alpha && alpha < beta && beta <= INF_SCORE);
+  const bool pv_node = beta - alpha > 1;
+  pv_length[ply] = ply;
+  if (visit_node(ply))
+    return 0;
+  STAT_INC(STAT_QNODES);
+
+  if (board.is_drawn() || board.is_repetition(1))
+    return DRAW_SCORE;
+  const bool in_check = board.king_in_check();
+  if (ply >= MAX_PLY - 1)
+    return in_check ? DRAW_SCORE : evaluate(board, &pawns);
+
+  const hash_t hash = board.hash();
+  bool tt_hit = false;
+  tt_entry_t *const tt_entry = searcher.m_tt.probe(hash, tt_hit);
+  STAT_INC(STAT_TT_PROBES);
+  STAT_INC_IF(tt_hit, STAT_TT_HITS);
+  const move_t tt_move = tt_hit ? tt_entry->move() : NULL_MOVE;
+  if (tt_hit && !pv_node) {
+    const int tt_score = score_from_tt(tt_entry->score(), ply);
+    const Bound bound = tt_entry->bound();
+    if (bound == BOUND_EXACT
+      || (bound == BOUND_LOWER && tt_score >= beta)
+      || (bound == BOUND_UPPER && tt_score <= alpha)) {
+      STAT_INC(STAT_TT_CUTOFFS);
+      return tt_score;
+    }
+  }
+
+  // Stand pat: the side to move can usually do at least as well as the static
+  // evaluation by playing a quiet move, except when in check
+  const int alpha_orig = alpha;
+  int best_score = -INF_SCORE, stand_pat = -INF_SCORE;
+  if (!in_check) {
+    stand_pat = best_score = evaluate(board, &pawns);
+    if (stand_pat >= beta)
+      return stand_pat;
+    alpha = std::max(alpha, stand_pat);
+  }
+
+  // Every evasion is searched when in check, so that mates are found
+  std::vector<move_t> moves = in_check ? board.generate_moves()
+    : board.tactical_moves(qply < QSEARCH_CHECK_PLIES);
+  std::vector<int> scores;
+  ordering.score_moves(board, moves, scores, tt_move, ply);
+
+  move_t best_move = NULL_MOVE;
+  unsigned legal_moves = 0;
+  for (size_t idx = 0; idx < moves.size(); ++idx) {
+    const move_t move = pick_move(moves, scores, idx);
+    if (!in_check) {
+      // Under-promotions are never better than the queen promotion
+      if (move_promoted(move) && !is_queen_promotion(move))
+        continue;
+      // Delta pruning
+      const piece_t victim = (move_flag(move) == EN_PASSANT_MOVE)
+        ? static_cast<piece_t>(WHITE_PAWN) : board.piece_at(move_to(move));
+      const int gain = (victim == INVALID_PIECE ? 0 : piece_value[victim])
+        + (move_promoted(move) ? piece_value[WHITE_QUEEN] - piece_value[WHITE_PAWN] : 0);
+      if (move_captured(move) && stand_pat + gain + searcher.m_params.delta_margin <= alpha)
+        continue;
+      // Losing exchanges are left to the full-width search
+      if (!board.see_ge(move, 0))
+        continue;
+    }
+
+    if (!board.make_move(move)) {
+      board.unmake_move();
+      continue;
+    }
+    legal_moves++;
+    searcher.m_tt.prefetch(board.hash());
+    const int score = -qsearch(-beta, -alpha, ply + 1, qply + 1);
+    board.unmake_move();
+    if (searcher.stopped())
+      return 0;
+
+    if (score > best_score) {
+      best_score = score;
+      if (score > alpha) {
+        best_move = move;
+        pv[ply][ply] = move;
+        for (int idx = ply + 1; idx < pv_length[ply + 1]; ++idx)
+          pv[ply][idx] = pv[ply + 1][idx];
+        pv_length[ply] = std::max(ply + 1, pv_length[ply + 1]);
+        if (score >= beta)
+          break;
+        alpha = score;
+      }
+    }
+  }
+
+  if (in_check && legal_moves == 0)
+    return mated_in(ply);
+
+  const Bound bound = (best_score >= beta) ? BOUND_LOWER
+    : (best_score > alpha_orig) ? BOUND_EXACT : BOUND_UPPER;
+  tt_entry->save(hash, score_to_tt(best_score, ply), in_check ? evaluate(board, &pawns) : stand_pat,
+    best_move, 0, bound, searcher.m_tt.generation());
+  return best_score;
+}
+
+Searcher::Searcher(TranspositionTable &tt) noexcept: m_tt(tt) {
+  init_reductions();
+  set_threads(1);
+}
+
+void Searcher::set_threads(const unsigned num_threads) noexcept {
+  m_threads.clear();
+  for (unsigned id = 0; id < std::max(num_threads, 1u); ++id)
+    m_threads.push_back(std::make_unique<search_thread_t>(*this, id));
+}
+
+void Searcher::clear() noexcept {
+  for (const auto &thread : m_threads) {
+    thread->ordering.clear();
+    thread->pawns.clear();
+  }
+}
+
+void Searcher::init_reductions() noexcept {
+  for (int depth = 0; depth <= MAX_PLY; ++depth) {
+    for (int moves = 0; moves < 64; ++moves) {
+      const double product = (depth == 0 || moves == 0) ? 0.0
+        : std::log(depth) * std::log(moves) * 100 / std::max(m_params.lmr_divisor, 1);
+      m_reductions[depth][moves] = std::max(0, (int)(m_params.lmr_base / 100.0 + product));
+    }
+  }
+}
+
+Searcher::~Searcher() noexcept {}
+
+size_t Searcher::nodes() const noexcept {
+  size_t result = 0;
+  for (const auto &thread : m_threads)
+    result += thread->nodes.load(std::memory_order_relaxed);
+  return result;
+}
+
+static inline int64_t clock_ns() noexcept {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+size_t Searcher::elapsed_ms() const noexcept {
+  return std::max<int64_t>(0, clock_ns() - m_clock_start.load(std::memory_order_relaxed)) / 1000000;
+}
+
+void Searcher::check_limits() noexcept {
+  if (m_limits.nodes != 0 && nodes() >= m_limits.nodes)
+    stop();
+  if (m_time.hard_ms() != 0 && !m_pondering.load(std::memory_order_relaxed)
+    && elapsed_ms() >= m_time.hard_ms())
+    stop();
+}
+
+void Searcher::ponderhit() noexcept {
+  m_clock_start.store(clock_ns(), std::memory_order_relaxed);
+  m_pondering.store(false, std::memory_order_relaxed);
+}
+
+void Searcher::arm(const search_limits_t &limits) noexcept {
+  m_stop.store(false, std::memory_order_relaxed);
+  m_pondering.store(limits.ponder, std::memory_order_relaxed);
+  m_clock_start.store(clock_ns(), std::memory_order_relaxed);
+  m_armed = true;
+}
+
+search_info_t Searcher::run(const Board &board, const search_limits_t &limits,
+  const info_callback_t &on_iteration) {
+  TRACE_SCOPE(PHASE, "search", limits.depth);
+  const auto start = std::chrono::steady_clock::now();
+  if (!m_armed)
+    arm(limits);
+  m_armed = false;
+  m_limits = limits;
+  init_reductions();
+  // A fixed time per move is only a hard deadline
+  time_budget_t budget = allocate_time(limits.clock);
+  if (limits.time_ms != 0)
+    budget = {0, limits.time_ms};
+  m_time.start(budget);
+  m_tt.new_search();
+
+  for (const auto &thread : m_threads)
+    thread->start(board);
+
+  std::vector<std::thread> helpers;
+  for (unsigned id = 1; id < m_threads.size(); ++id) {
+    search_thread_t &thread = *m_threads[id];
+    helpers.emplace_back([&thread, &on_iteration, start] {
+      thread.iterate(on_iteration, start);
+    });
+  }
+  m_threads[0]->iterate(on_iteration, start);
+  // The main thread decides when the search is over
+  stop();
+  for (auto &helper : helpers)
+    helper.join();
+
+  // Take the deepest completed iteration, preferring the main thread on ties
+  const search_thread_t *best = m_threads[0].get();
+  for (const auto &thread : m_threads) {
+    if (thread->result.depth > best->result.depth && !thread->result.pv.empty()
+      && thread->result.score > -MATE_IN_MAX_PLY)
+      best = thread.get();
+  }
+  search_info_t result = best->result;
+  result.nodes = nodes();
+  result.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now() - start).count();
+  return result;
+}
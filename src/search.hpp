@@ -0,0 +1,160 @@
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "defs.hpp"
+#include "board.hpp"
+#include "move.hpp"
+#include "timeman.hpp"
+#include "tt.hpp"
+
+// NOTE: The deepest ply the search will ever reach from the root.
+enum { MAX_PLY = 128 };
+
+enum {
+  DRAW_SCORE = 0,
+  MATE_SCORE = 32000,
+  INF_SCORE = 32001,
+  // Scores beyond this bound are mates, with the distance encoded in plies
+  MATE_IN_MAX_PLY = MATE_SCORE - MAX_PLY,
+};
+
+constexpr inline int mate_in(const int ply) { return MATE_SCORE - ply; }
+constexpr inline int mated_in(const int ply) { return -MATE_SCORE + ply; }
+constexpr inline bool is_mate_score(const int score) {
+  return score >= MATE_IN_MAX_PLY || score <= -MATE_IN_MAX_PLY;
+}
+// Full moves to mate for a mate score, negative when getting mated
+constexpr inline int mate_moves(const int score) {
+  return (score > 0) ? (MATE_SCORE - score + 1) / 2 : -(MATE_SCORE + score) / 2;
+}
+
+// Selective search margins and reductions, settable by name for tuning.
+// Margins are in centipawns; a max depth of 0 disables a technique.
+struct search_params_t {
+  // Null move pruning, reduced by nmp_reduction + depth / nmp_depth_divisor
+  int nmp_min_depth = 3, nmp_reduction = 3, nmp_depth_divisor = 4, nmp_verify_depth = 12;
+  // Late move reductions of ln(depth) * ln(moves) * 100 / lmr_divisor
+  // + lmr_base / 100 plies, after lmr_min_moves moves
+  int lmr_min_depth = 3, lmr_min_moves = 3, lmr_base = 75, lmr_divisor = 225;
+  // Reverse futility: fail high when the static eval beats beta by a margin
+  int rfp_max_depth = 7, rfp_margin = 80;
+  // Futility: skip quiet moves when the static eval is far below alpha
+  int futility_max_depth = 6, futility_base = 100, futility_margin = 90;
+  // Razoring: drop into quiescence when far below alpha
+  int razor_max_depth = 3, razor_base = 200, razor_margin = 200;
+  // Late move pruning: skip quiets after lmp_base + depth * depth of them
+  int lmp_max_depth = 8, lmp_base = 3;
+  // Delta pruning margin in the quiescence search
+  int delta_margin = 200;
+
+  // Return false for unknown names. Values are clamped to the range.
+  bool set(const std::string &name, const int value) noexcept;
+  bool get(const std::string &name, int &value) const noexcept;
+  static bool range(const std::string &name, int &min, int &max) noexcept;
+  static std::vector<std::string> names() noexcept;
+};
+
+struct search_limits_t {
+  int depth = MAX_PLY - 1;
+  size_t nodes = 0;   // Across all threads, 0 for no limit
+  size_t time_ms = 0; // Fixed time for the move, 0 for no limit
+  // Budgeted by the time manager when there is no fixed time
+  time_control_t clock;
+  // Time limits only start counting after ponderhit()
+  bool ponder = false;
+  // The number of best root moves to search exactly
+  int multi_pv = 1;
+};
+
+struct pv_line_t {
+  int score = -INF_SCORE;
+  std::vector<move_t> pv;
+};
+
+// The result of one completed iteration of the search
+struct search_info_t {
+  int depth = 0;
+  int seldepth = 0;
+  int score = -INF_SCORE;
+  size_t nodes = 0;
+  size_t time_ns = 0;
+  std::vector<move_t> pv;
+  // The best multi_pv root moves and their lines, best first. The first line
+  // is the score and pv above.
+  std::vector<pv_line_t> lines;
+
+  inline move_t best_move() const noexcept { return pv.empty() ? NULL_MOVE : pv[0]; }
+};
+
+using info_callback_t = std::function<void(const search_info_t &)>;
+
+struct search_thread_t;
+
+// Lazy SMP: every thread runs its own iterative deepening on a private copy of
+// the board, and the threads only communicate through the shared transposition
+// table. Helper threads search at staggered depths so they fill the table with
+// results the main thread needs next.
+class Searcher {
+  TranspositionTable &m_tt;
+  search_limits_t m_limits;
+  search_params_t m_params;
+  // Late move reductions by depth and move number, from m_params
+  std::array<std::array<int, 64>, MAX_PLY + 1> m_reductions;
+  std::atomic<bool> m_stop{false};
+  std::atomic<bool> m_pondering{false};
+  // Set by arm() so that run() keeps a stop or ponderhit that came in between
+  bool m_armed = false;
+  // When the clock started, in steady_clock nanoseconds
+  std::atomic<int64_t> m_clock_start{0};
+  // Only touched by the main search thread once the search has started
+  TimeManager m_time;
+  std::vector<std::unique_ptr<search_thread_t>> m_threads;
+
+  friend struct search_thread_t;
+  void check_limits() noexcept;
+  size_t elapsed_ms() const noexcept;
+  void init_reductions() noexcept;
+
+public:
+  explicit Searcher(TranspositionTable &tt) noexcept;
+  ~Searcher() noexcept;
+
+  // Only to be called between searches. Thread state, such as move ordering
+  // history and pawn tables, is kept from one search to the next until the
+  // number of threads changes or clear() is called.
+  void set_threads(const unsigned num_threads) noexcept;
+  inline unsigned threads() const noexcept { return (unsigned)m_threads.size(); }
+  // Forgets what earlier searches learned, as for a new game
+  void clear() noexcept;
+  inline TranspositionTable &tt() const noexcept { return m_tt; }
+  // Only to be changed between searches
+  inline search_params_t &params() noexcept { return m_params; }
+
+  // Clears any earlier stop and starts the clock for a search with limits.
+  // A caller whose stop() and ponderhit() come from another thread calls this
+  // under the same lock as it takes the job, before run(), so that neither is
+  // lost in between; otherwise run() arms itself.
+  void arm(const search_limits_t &limits) noexcept;
+  // Blocks until the limits are reached or stop() is called from another
+  // thread, and returns the deepest completed iteration over all threads.
+  // on_iteration is only called from the main search thread.
+  search_info_t run(const Board &board, const search_limits_t &limits,
+    const info_callback_t &on_iteration = nullptr);
+  inline void stop() noexcept { m_stop.store(true, std::memory_order_relaxed); }
+  // The pondered move was played: the time limit applies from now on
+  void ponderhit() noexcept;
+  inline bool stopped() const noexcept { return m_stop.load(std::memory_order_relaxed); }
+  size_t nodes() const noexcept;
+};
+
+#endif /* end of include guard: SEARCH_H */
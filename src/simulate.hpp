@@ -1,8 +1,14 @@
 
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include "board.hpp"
+#include "tb.hpp"
+#include "timeman.hpp"
 #include <iostream>
 #include <vector>
 #include "strategies/random_strat.hpp"
@@ -12,19 +18,65 @@ struct game_record {
   std::string fen;
   int result;
   std::vector<move_t> moves;
+  // Lost by the side that ran out of time
+  bool time_forfeit = false;
 };
 
+// Strategies with a set_clock method are told their remaining time before each move
+template <typename Strategy, typename = void>
+struct uses_clock : std::false_type {};
+template <typename Strategy>
+struct uses_clock<Strategy, std::void_t<decltype(std::declval<Strategy &>().set_clock(time_control_t()))>>
+  : std::true_type {};
+
+// Plays a game out, with both sides on the given clock if it is timed: the
+// time each choice takes is charged to the side to move, and a side that runs
+// out loses. With moves_to_go set, the time is added again every moves_to_go
+// moves.
 template <typename WhiteStrategy, typename BlackStrategy>
-game_record simulate_game(WhiteStrategy white_strat, BlackStrategy black_strat, const std::string &fen = Board::startFEN) {
+game_record simulate_game(WhiteStrategy white_strat, BlackStrategy black_strat, const std::string &fen = Board::startFEN,
+  const time_control_t &clock = time_control_t()) {
   game_record result;
   result.fen = fen;
   Board board(fen);
   white_strat.init(board);
   black_strat.init(board);
-  while (true) {
+  const bool timed = clock.time_ms != 0;
+  int64_t remaining_ms[2] = {(int64_t)clock.time_ms, (int64_t)clock.time_ms};
+  size_t moves_to_go[2] = {clock.moves_to_go, clock.moves_to_go};
+  while (!board.is_drawn()) {
+    // Tablebase positions are decided without playing them out
+    tb::probe_result_t tb_result;
+    if (tb::probe(board, tb_result)) {
+      result.result = (board.m_next_move_colour == WHITE) ? tb_result.wdl : -tb_result.wdl;
+      return result;
+    }
     const auto &move_list = board.legal_moves();
     if (move_list.empty()) break;
-    const size_t move_idx = (board.m_next_move_colour == WHITE) ? white_strat.choose(board, move_list) : black_strat.choose(board, move_list);
+    const int side = board.m_next_move_colour;
+    const time_control_t side_clock = {(size_t)std::max<int64_t>(remaining_ms[side], 1),
+      clock.increment_ms, moves_to_go[side]};
+    if constexpr (uses_clock<WhiteStrategy>::value)
+      if (side == WHITE) white_strat.set_clock(side_clock);
+    if constexpr (uses_clock<BlackStrategy>::value)
+      if (side == BLACK) black_strat.set_clock(side_clock);
+
+    const auto start = std::chrono::steady_clock::now();
+    const size_t move_idx = (side == WHITE) ? white_strat.choose(board, move_list) : black_strat.choose(board, move_list);
+    if (timed) {
+      remaining_ms[side] -= std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start).count();
+      if (remaining_ms[side] < 0) {
+        result.result = (side == WHITE) ? -1 : 1;
+        result.time_forfeit = true;
+        return result;
+      }
+      remaining_ms[side] += clock.increment_ms;
+      if (clock.moves_to_go > 0 && --moves_to_go[side] == 0) {
+        remaining_ms[side] += clock.time_ms;
+        moves_to_go[side] = clock.moves_to_go;
+      }
+    }
     board.make_move(move_list[move_idx]);
     result.moves.push_back(move_list[move_idx]);
   }
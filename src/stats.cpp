@@ -0,0 +1,109 @@
+
+#include "stats.hpp"
+
+#include <iomanip>
+#include <mutex>
+#include <vector>
+
+void stats_t::add(const stats_t &other) noexcept {
+  for (size_t idx = 0; idx < NUM_STATS; ++idx)
+    counts[idx] += other.counts[idx];
+  for (size_t hist = 0; hist < NUM_HISTOGRAMS; ++hist)
+    for (size_t idx = 0; idx < HISTOGRAM_SIZE; ++idx)
+      histograms[hist][idx] += other.histograms[hist][idx];
+}
+
+namespace stats {
+
+static std::mutex registry_mutex;
+// Counters of running threads, and the sum over finished ones
+static std::vector<stats_t *> live_stats;
+static stats_t finished_stats;
+
+struct thread_stats_t {
+  stats_t stats;
+
+  thread_stats_t() noexcept {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    live_stats.push_back(&stats);
+  }
+  ~thread_stats_t() noexcept {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    finished_stats.add(stats);
+    live_stats.erase(std::find(live_stats.begin(), live_stats.end(), &stats));
+  }
+};
+
+stats_t &local() noexcept {
+  thread_local thread_stats_t thread_stats;
+  return thread_stats.stats;
+}
+
+stats_t total() noexcept {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  stats_t result = finished_stats;
+  for (const stats_t *const stats : live_stats)
+    result.add(*stats);
+  return result;
+}
+
+void reset() noexcept {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  finished_stats = stats_t();
+  for (stats_t *const stats : live_stats)
+    *stats = stats_t();
+}
+
+#ifdef STATS
+static double percent(const uint64_t part, const uint64_t whole) noexcept {
+  return whole == 0 ? 0.0 : 100.0 * part / whole;
+}
+#endif
+
+void report(std::ostream &out) noexcept {
+#ifdef STATS
+  const stats_t stats = total();
+  const auto &counts = stats.counts;
+  const auto line = [&](const char *name, const uint64_t value) -> std::ostream & {
+    return out << std::left << std::setw(20) << name << std::right << std::setw(16) << value;
+  };
+  out << "===== STATS =====\n" << std::fixed << std::setprecision(1);
+  line("nodes", counts[STAT_NODES]) << '\n';
+  line("qnodes", counts[STAT_QNODES]) << " (" << percent(counts[STAT_QNODES],
+    counts[STAT_NODES] + counts[STAT_QNODES]) << "% of all)\n";
+  line("tt probes", counts[STAT_TT_PROBES]) << '\n';
+  line("tt hits", counts[STAT_TT_HITS]) << " (" << percent(counts[STAT_TT_HITS], counts[STAT_TT_PROBES]) << "%)\n";
+  line("tt cutoffs", counts[STAT_TT_CUTOFFS]) << " (" << percent(counts[STAT_TT_CUTOFFS], counts[STAT_TT_HITS]) << "% of hits)\n";
+  line("fail highs", counts[STAT_FAIL_HIGHS]) << '\n';
+  line("first move", counts[STAT_FAIL_HIGHS_FIRST]) << " (" << percent(counts[STAT_FAIL_HIGHS_FIRST],
+    counts[STAT_FAIL_HIGHS]) << "% of fail highs)\n";
+  line("move cache probes", counts[STAT_MOVE_CACHE_PROBES]) << '\n';
+  line("move cache hits", counts[STAT_MOVE_CACHE_HITS]) << " (" << percent(counts[STAT_MOVE_CACHE_HITS],
+    counts[STAT_MOVE_CACHE_PROBES]) << "%)\n";
+  line("make moves", counts[STAT_MAKE_MOVES]) << '\n';
+  line("unmake moves", counts[STAT_UNMAKE_MOVES]) << '\n';
+
+  // Histograms in buckets of eight moves
+  const char *const names[NUM_HISTOGRAMS] = {"generated moves", "tactical moves"};
+  for (size_t hist = 0; hist < NUM_HISTOGRAMS; ++hist) {
+    uint64_t calls = 0, moves = 0;
+    for (size_t size = 0; size < HISTOGRAM_SIZE; ++size) {
+      calls += stats.histograms[hist][size];
+      moves += stats.histograms[hist][size] * size;
+    }
+    out << names[hist] << ": " << calls << " calls, " << (calls == 0 ? 0.0 : (double)moves / calls)
+      << " moves on average\n";
+    for (size_t first = 0; first < HISTOGRAM_SIZE && calls > 0; first += 8) {
+      uint64_t bucket = 0;
+      for (size_t size = first; size < first + 8; ++size)
+        bucket += stats.histograms[hist][size];
+      if (bucket > 0)
+        out << "  " << std::setw(3) << first << "-" << std::left << std::setw(3) << first + 7 << std::right
+          << std::setw(14) << bucket << " (" << percent(bucket, calls) << "%)\n";
+    }
+  }
+  out << std::defaultfloat;
+#endif
+}
+
+} // namespace stats
@@ -0,0 +1,77 @@
+
+#ifndef STATS_H
+#define STATS_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+/*
+STATS:
+Event counters for the search and move generation, compiled in with -D STATS
+(make STATS=true) and compiled out entirely otherwise: the STAT_ macros expand
+to nothing, so normal builds do not even evaluate their arguments.
+- Every thread counts into its own thread_local stats_t, so counting is a
+  plain increment with no sharing between threads.
+- A thread's counts are folded into a global total when it exits, and
+  stats::report adds the totals of the threads still running.
+*/
+
+enum Stat {
+  STAT_NODES,
+  STAT_QNODES,
+  STAT_TT_PROBES,
+  STAT_TT_HITS,
+  STAT_TT_CUTOFFS,
+  STAT_FAIL_HIGHS,
+  STAT_FAIL_HIGHS_FIRST, // Fail highs on the first legal move
+  STAT_MOVE_CACHE_PROBES,
+  STAT_MOVE_CACHE_HITS,
+  STAT_MAKE_MOVES,
+  STAT_UNMAKE_MOVES,
+  NUM_STATS,
+};
+
+// Histograms of the number of moves generated per call
+enum StatHistogram {
+  HIST_MOVES,    // generate_moves
+  HIST_TACTICAL, // tactical_moves
+  NUM_HISTOGRAMS,
+};
+
+// Move counts past the last bucket are counted in it
+enum { HISTOGRAM_SIZE = 256 };
+
+struct stats_t {
+  std::array<uint64_t, NUM_STATS> counts{};
+  std::array<std::array<uint64_t, HISTOGRAM_SIZE>, NUM_HISTOGRAMS> histograms{};
+
+  void add(const stats_t &other) noexcept;
+};
+
+namespace stats {
+
+// The counters of the calling thread
+stats_t &local() noexcept;
+// The counts of every thread so far
+stats_t total() noexcept;
+void reset() noexcept;
+// Prints the totals, or nothing when stats are compiled out
+void report(std::ostream &out) noexcept;
+
+} // namespace stats
+
+#ifdef STATS
+  #define STAT_INC(stat) (++stats::local().counts[stat])
+  #define STAT_INC_IF(cond, stat) do { if (cond) STAT_INC(stat); } while (0)
+  #define STAT_HISTOGRAM(histogram, size) \
+    (++stats::local().histograms[histogram][std::min<size_t>(size, HISTOGRAM_SIZE - 1)])
+#else
+  #define STAT_INC(stat) do {} while (0)
+  #define STAT_INC_IF(cond, stat) do {} while (0)
+  #define STAT_HISTOGRAM(histogram, size) do {} while (0)
+#endif
+
+#endif /* end of include guard: STATS_H */
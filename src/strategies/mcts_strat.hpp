@@ -0,0 +1,356 @@
+
+#pragma once
+
+#include "strategies/strategy.hpp"
+#include "hash.hpp"
+#include "board.hpp"
+#include "move.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/*
+MCTS NODE:
+- move         - the move into this node, played by the side not to move here
+- first_child  - children are allocated as one contiguous block of the arena
+- state        - unexpanded, being expanded by some thread, expanded, or
+                 terminal (mate or draw, scored without a playout)
+- visits       - completed playouts through this node
+- virtual_loss - playouts currently in flight through this node, counted as
+                 losses so concurrent threads spread over different lines
+- points       - half points for the side that played move: 2 per win, 1 per
+                 draw, so they stay unsigned under concurrent updates
+*/
+struct mcts_node_t {
+  enum : uint8_t { UNEXPANDED, EXPANDING, EXPANDED, TERMINAL };
+
+  move_t move = NULL_MOVE;
+  uint32_t first_child = 0;
+  uint32_t num_children = 0;
+  std::atomic<uint8_t> state{UNEXPANDED};
+  std::atomic<uint32_t> visits{0};
+  std::atomic<uint32_t> virtual_loss{0};
+  std::atomic<uint64_t> points{0};
+};
+
+// Fixed-size node pool with a bump allocator. Nodes are never freed one by
+// one: when the reused subtree and the new search no longer fit, the subtree
+// is compacted into a second pool and the pools are swapped.
+class MCTSArena {
+  std::unique_ptr<mcts_node_t[]> m_nodes;
+  uint32_t m_capacity;
+  std::atomic<uint32_t> m_used{0};
+
+public:
+  explicit MCTSArena(const uint32_t capacity) noexcept:
+    m_nodes(new mcts_node_t[capacity]), m_capacity(capacity) {}
+
+  inline mcts_node_t &operator[](const uint32_t idx) noexcept { return m_nodes[idx]; }
+  inline uint32_t used() const noexcept { return m_used.load(std::memory_order_relaxed); }
+  inline uint32_t capacity() const noexcept { return m_capacity; }
+
+  // Index of the first of count fresh nodes, or capacity() if full
+  inline uint32_t allocate(const uint32_t count) noexcept {
+    uint32_t start = m_used.load(std::memory_order_relaxed);
+    do {
+      if (start + count > m_capacity)
+        return m_capacity;
+    } while (!m_used.compare_exchange_weak(start, start + count, std::memory_order_relaxed));
+    for (uint32_t idx = start; idx < start + count; ++idx)
+      reset(m_nodes[idx]);
+    return start;
+  }
+
+  inline void clear() noexcept { m_used.store(0, std::memory_order_relaxed); }
+
+  static inline void reset(mcts_node_t &node) noexcept {
+    node.move = NULL_MOVE;
+    node.first_child = node.num_children = 0;
+    node.state.store(mcts_node_t::UNEXPANDED, std::memory_order_relaxed);
+    node.visits.store(0, std::memory_order_relaxed);
+    node.virtual_loss.store(0, std::memory_order_relaxed);
+    node.points.store(0, std::memory_order_relaxed);
+  }
+};
+
+// UCT search over random playouts, tree-parallel over num_threads threads
+// sharing one tree. The subtree under the chosen move and the opponent's
+// reply is kept for the next call to choose.
+class MCTSStrategy : Strategy {
+  struct tree_t {
+    MCTSArena arenas[2];
+    int current = 0;
+    uint32_t root = 0;
+    hash_t root_hash = 0;
+    bool has_root = false;
+    // Playouts already through the root when the last choose started
+    uint32_t reused_visits = 0;
+
+    explicit tree_t(const uint32_t capacity) noexcept:
+      arenas{MCTSArena(capacity), MCTSArena(capacity)} {}
+    inline MCTSArena &arena() noexcept { return arenas[current]; }
+  };
+
+  // Shared, so that strategies can be passed by value to simulate_game
+  std::shared_ptr<tree_t> m_tree;
+  size_t m_iterations;
+  unsigned m_threads;
+  double m_exploration;
+
+  // Legal moves by generating pseudo-legal ones and making each
+  static std::vector<move_t> legal(Board &board) noexcept {
+    std::vector<move_t> result;
+    for (const move_t move : board.generate_moves()) {
+      if (board.make_move(move))
+        result.push_back(move);
+      board.unmake_move();
+    }
+    return result;
+  }
+
+  // Result for white: 1 for a win, 0 for a draw, -1 for a loss
+  static int terminal_result(const Board &board) noexcept {
+    if (board.is_drawn() || !board.king_in_check())
+      return 0;
+    return (board.m_next_move_colour == WHITE) ? -1 : 1;
+  }
+
+  // Random moves until the game ends. Moves are picked among the pseudo-legal
+  // ones, and illegal picks are dropped and redrawn, which is much cheaper
+  // than generating the legal moves first.
+  static int playout(Board &board, std::mt19937_64 &rng) noexcept {
+    while (!board.is_drawn()) {
+      std::vector<move_t> moves = board.generate_moves();
+      bool moved = false;
+      while (!moves.empty()) {
+        const size_t idx = rng() % moves.size();
+        if (board.make_move(moves[idx])) {
+          moved = true;
+          break;
+        }
+        board.unmake_move();
+        moves[idx] = moves.back();
+        moves.pop_back();
+      }
+      if (!moved)
+        return terminal_result(board);
+    }
+    return 0;
+  }
+
+  // Expands node at the position on board, returns false if another thread is
+  // expanding it or the arena is full
+  static bool expand(MCTSArena &arena, mcts_node_t &node, Board &board) noexcept {
+    uint8_t expected = mcts_node_t::UNEXPANDED;
+    if (!node.state.compare_exchange_strong(expected, mcts_node_t::EXPANDING,
+        std::memory_order_acquire))
+      return false;
+    const std::vector<move_t> moves = board.is_drawn() ? std::vector<move_t>() : legal(board);
+    if (moves.empty()) {
+      node.state.store(mcts_node_t::TERMINAL, std::memory_order_release);
+      return true;
+    }
+    const uint32_t first = arena.allocate(moves.size());
+    if (first == arena.capacity()) {
+      node.state.store(mcts_node_t::UNEXPANDED, std::memory_order_release);
+      return false;
+    }
+    for (size_t idx = 0; idx < moves.size(); ++idx)
+      arena[first + idx].move = moves[idx];
+    node.first_child = first;
+    node.num_children = moves.size();
+    node.state.store(mcts_node_t::EXPANDED, std::memory_order_release);
+    return true;
+  }
+
+  uint32_t select(MCTSArena &arena, const mcts_node_t &node) const noexcept {
+    const double parent_visits = std::max<uint32_t>(1, node.visits.load(std::memory_order_relaxed)
+      + node.virtual_loss.load(std::memory_order_relaxed));
+    const double log_visits = std::log(parent_visits);
+    uint32_t best = node.first_child;
+    double best_value = -1.0;
+    for (uint32_t idx = node.first_child; idx < node.first_child + node.num_children; ++idx) {
+      const mcts_node_t &child = arena[idx];
+      const uint32_t visits = child.visits.load(std::memory_order_relaxed)
+        + child.virtual_loss.load(std::memory_order_relaxed);
+      if (visits == 0)
+        return idx;
+      const double mean = child.points.load(std::memory_order_relaxed) / (2.0 * visits);
+      const double value = mean + m_exploration * std::sqrt(log_visits / visits);
+      if (value > best_value) {
+        best_value = value;
+        best = idx;
+      }
+    }
+    return best;
+  }
+
+  void iterate(const Board &root_board, std::atomic<int64_t> &remaining,
+    const uint64_t seed) noexcept {
+    MCTSArena &arena = m_tree->arena();
+    std::mt19937_64 rng(seed);
+    std::vector<uint32_t> path;
+    while (remaining.fetch_sub(1, std::memory_order_relaxed) > 0) {
+      Board board = root_board;
+      path.assign(1, m_tree->root);
+      int result = 0;
+      while (true) {
+        mcts_node_t &node = arena[path.back()];
+        const uint8_t state = node.state.load(std::memory_order_acquire);
+        if (state == mcts_node_t::EXPANDED) {
+          const uint32_t child = select(arena, node);
+          arena[child].virtual_loss.fetch_add(1, std::memory_order_relaxed);
+          board.make_move(arena[child].move);
+          path.push_back(child);
+          continue;
+        }
+        if (state == mcts_node_t::TERMINAL) {
+          result = terminal_result(board);
+          break;
+        }
+        // Leaves are expanded on their second visit, the root always
+        if (state == mcts_node_t::UNEXPANDED
+          && (path.size() == 1 || node.visits.load(std::memory_order_relaxed) > 0)
+          && expand(arena, node, board))
+          continue;
+        result = playout(board, rng);
+        break;
+      }
+
+      // Points are for the side that played the move into each node
+      bool mover = !root_board.m_next_move_colour;
+      for (size_t idx = 0; idx < path.size(); ++idx, mover = !mover) {
+        mcts_node_t &node = arena[path[idx]];
+        const int points = (mover == WHITE) ? result + 1 : 1 - result;
+        node.points.fetch_add(points, std::memory_order_relaxed);
+        node.visits.fetch_add(1, std::memory_order_relaxed);
+        if (idx > 0)
+          node.virtual_loss.fetch_sub(1, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Copies the subtree under root into the other arena, breadth first so that
+  // sibling blocks stay contiguous
+  void compact() noexcept {
+    MCTSArena &from = m_tree->arena(), &to = m_tree->arenas[1 - m_tree->current];
+    to.clear();
+    const uint32_t new_root = to.allocate(1);
+    std::vector<std::pair<uint32_t, uint32_t>> queue = {{m_tree->root, new_root}};
+    for (size_t head = 0; head < queue.size(); ++head) {
+      const mcts_node_t &src = from[queue[head].first];
+      mcts_node_t &dst = to[queue[head].second];
+      dst.move = src.move;
+      dst.visits.store(src.visits.load());
+      dst.points.store(src.points.load());
+      const uint8_t state = src.state.load();
+      dst.state.store(state == mcts_node_t::EXPANDING ? (uint8_t)mcts_node_t::UNEXPANDED : state);
+      if (state != mcts_node_t::EXPANDED)
+        continue;
+      dst.first_child = to.allocate(src.num_children);
+      dst.num_children = src.num_children;
+      for (uint32_t idx = 0; idx < src.num_children; ++idx)
+        queue.emplace_back(src.first_child + idx, dst.first_child + idx);
+    }
+    m_tree->current = 1 - m_tree->current;
+    m_tree->root = new_root;
+  }
+
+  void reset_root(const Board &board) noexcept {
+    m_tree->arena().clear();
+    m_tree->root = m_tree->arena().allocate(1);
+    m_tree->root_hash = board.hash();
+    m_tree->has_root = true;
+  }
+
+  // Follows the opponent's reply from the stored root, if it was searched
+  bool reuse_root(const Board &board) noexcept {
+    if (!m_tree->has_root)
+      return false;
+    if (m_tree->root_hash == board.hash())
+      return true;
+    if (board.m_history.empty() || board.m_history.back().hash != m_tree->root_hash)
+      return false;
+    const mcts_node_t &root = m_tree->arena()[m_tree->root];
+    if (root.state.load() != mcts_node_t::EXPANDED)
+      return false;
+    for (uint32_t idx = root.first_child; idx < root.first_child + root.num_children; ++idx) {
+      if (m_tree->arena()[idx].move == board.m_history.back().move) {
+        m_tree->root = idx;
+        m_tree->root_hash = board.hash();
+        return true;
+      }
+    }
+    return false;
+  }
+
+public:
+  enum { DEFAULT_NODES = 1 << 20 };
+
+  MCTSStrategy(const size_t iterations = 2000, const unsigned threads = 1,
+    const uint32_t max_nodes = DEFAULT_NODES, const double exploration = 1.4) noexcept:
+    m_tree(std::make_shared<tree_t>(max_nodes)), m_iterations(iterations),
+    m_threads(threads > 0 ? threads : 1), m_exploration(exploration) {}
+
+  void init(Board board) override { reset_root(board); }
+
+  size_t choose(Board board, const std::vector<move_t> &move_list) override {
+    board.m_move_cache.clear();
+    if (!reuse_root(board))
+      reset_root(board);
+    else if (m_tree->arena().used() > m_tree->arena().capacity() / 2)
+      compact();
+    m_tree->reused_visits = root_visits();
+
+    std::atomic<int64_t> remaining{(int64_t)m_iterations};
+    std::vector<std::thread> helpers;
+    for (unsigned id = 1; id < m_threads; ++id) {
+      const uint64_t seed = random_hash();
+      helpers.emplace_back([this, &board, &remaining, seed] { iterate(board, remaining, seed); });
+    }
+    iterate(board, remaining, random_hash());
+    for (auto &helper : helpers)
+      helper.join();
+
+    // The most visited move is the most robust choice
+    const mcts_node_t &root = m_tree->arena()[m_tree->root];
+    if (root.state.load() != mcts_node_t::EXPANDED)
+      return 0;
+    uint32_t best = root.first_child;
+    for (uint32_t idx = root.first_child; idx < root.first_child + root.num_children; ++idx)
+      if (m_tree->arena()[idx].visits.load() > m_tree->arena()[best].visits.load())
+        best = idx;
+    const move_t move = m_tree->arena()[best].move;
+    for (size_t idx = 0; idx < move_list.size(); ++idx) {
+      if (move_list[idx] == move) {
+        board.make_move(move);
+        m_tree->root = best;
+        m_tree->root_hash = board.hash();
+        return idx;
+      }
+    }
+    return 0;
+  }
+
+  // Playouts through the current root, including reused ones
+  inline uint32_t root_visits() const noexcept {
+    return m_tree->arena()[m_tree->root].visits.load();
+  }
+  inline uint32_t reused_visits() const noexcept { return m_tree->reused_visits; }
+  // Playouts through the child of the current root reached by move
+  uint32_t child_visits(const move_t move) const noexcept {
+    const mcts_node_t &root = m_tree->arena()[m_tree->root];
+    if (root.state.load() != mcts_node_t::EXPANDED)
+      return 0;
+    for (uint32_t idx = root.first_child; idx < root.first_child + root.num_children; ++idx)
+      if (m_tree->arena()[idx].move == move)
+        return m_tree->arena()[idx].visits.load();
+    return 0;
+  }
+  inline uint32_t nodes_used() const noexcept { return m_tree->arena().used(); }
+};
@@ -0,0 +1,46 @@
+
+#pragma once
+
+#include "strategies/strategy.hpp"
+#include "board.hpp"
+#include "move.hpp"
+#include "search.hpp"
+#include "timeman.hpp"
+#include "tt.hpp"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+// Alpha-beta search within fixed limits, or within the game clock when
+// simulate_game passes one in
+class SearchStrategy : Strategy {
+  struct engine_t {
+    TranspositionTable tt;
+    Searcher searcher;
+
+    explicit engine_t(const size_t hash_mb) noexcept : tt(hash_mb), searcher(tt) {}
+  };
+
+  // Shared, so that strategies can be passed by value to simulate_game
+  std::shared_ptr<engine_t> m_engine;
+  search_limits_t m_limits;
+
+public:
+  explicit SearchStrategy(const search_limits_t &limits = search_limits_t(),
+    const size_t hash_mb = TranspositionTable::DEFAULT_SIZE_MB, const unsigned threads = 1) noexcept:
+    m_engine(std::make_shared<engine_t>(hash_mb)), m_limits(limits) {
+    m_engine->searcher.set_threads(threads);
+  }
+
+  void init(Board board) override {
+    m_engine->tt.clear();
+    m_engine->searcher.clear();
+  }
+  void set_clock(const time_control_t &clock) noexcept { m_limits.clock = clock; }
+
+  size_t choose(Board board, const std::vector<move_t> &move_list) override {
+    const move_t best = m_engine->searcher.run(board, m_limits).best_move();
+    const auto it = std::find(move_list.begin(), move_list.end(), best);
+    return it == move_list.end() ? 0 : it - move_list.begin();
+  }
+};
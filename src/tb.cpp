@@ -0,0 +1,722 @@
+
+#include "tb.hpp"
+#include "eval.hpp"
+#include "move.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>    // for open
+#include <sys/mman.h> // for mmap
+#include <sys/stat.h> // for fstat
+#include <unistd.h>   // for close
+
+namespace tb {
+
+enum : uint8_t { INVALID = 0, DRAW = 1, MATED = 2 };
+enum : uint32_t {
+  FILE_MAGIC = 0x42544350, // "PCTB"
+  FILE_VERSION = 1,
+};
+enum { MAX_DTM = 255 - MATED };
+
+using squares_t = std::array<int, MAX_PIECES>;
+
+// The white king squares of the index, the a1-d1-d4 triangle
+constexpr int triangle_squares[10] = {0, 1, 2, 3, 9, 10, 11, 18, 19, 27};
+
+// Mirrors a 64-square index along the a1-h8 diagonal
+static inline int transpose(const int sq) noexcept {
+  return 8 * (sq % 8) + sq / 8;
+}
+
+// Pieces in index order: the white king, the other white pieces, the black
+// king, the other black pieces
+struct spec_t {
+  std::string name;
+  std::vector<piece_t> pieces;
+  size_t size = 0;
+};
+
+// "KRB" style letters for side, empty if side has pawns
+static std::string side_letters(const Board &board, const int side) noexcept {
+  const piece_t base = (side == WHITE) ? 0 : 8;
+  if (board.m_num_pieces[base + WHITE_PAWN] > 0)
+    return "";
+  std::string result = "K";
+  for (const piece_t piece : {WHITE_QUEEN, WHITE_ROOK, WHITE_BISHOP, WHITE_KNIGHT})
+    result.append(board.m_num_pieces[base + piece], char_from_piece(piece));
+  return result;
+}
+
+static int letters_value(const std::string &letters) noexcept {
+  int result = 0;
+  for (const char chr : letters)
+    result += piece_value[piece_from_char(chr)];
+  return result;
+}
+
+// Whether the side with these letters goes second in a table name
+static bool weaker(const std::string &letters, const std::string &other) noexcept {
+  const int value = letters_value(letters), other_value = letters_value(other);
+  return value != other_value ? value < other_value : letters < other;
+}
+
+// The table name for the two sides, and whether their colours are swapped in it
+static std::string canonical_name(const std::string &white, const std::string &black,
+  bool &flip) noexcept {
+  flip = weaker(white, black);
+  return flip ? black + "v" + white : white + "v" + black;
+}
+
+static bool parse_name(const std::string &name, spec_t &spec) noexcept {
+  const size_t split = name.find('v');
+  if (split == std::string::npos)
+    return false;
+  const std::string white = name.substr(0, split), black = name.substr(split + 1);
+  if (white.empty() || black.empty() || white.size() + black.size() > MAX_PIECES
+    || white.size() + black.size() < 3)
+    return false;
+  bool flip;
+  if (canonical_name(white, black, flip) != name || flip)
+    return false;
+
+  spec.name = name;
+  spec.pieces.clear();
+  for (const std::string &letters : {white, black}) {
+    const piece_t base = spec.pieces.empty() ? 0 : 8;
+    if (letters[0] != 'K')
+      return false;
+    spec.pieces.push_back(base + WHITE_KING);
+    // Pieces in the order side_letters writes them
+    const std::string order = "QRBN";
+    size_t last = 0;
+    for (size_t idx = 1; idx < letters.size(); ++idx) {
+      const size_t pos = order.find(letters[idx]);
+      if (pos == std::string::npos || pos < last)
+        return false;
+      last = pos;
+      spec.pieces.push_back(base + piece_from_char(letters[idx]));
+    }
+  }
+  spec.size = 10 * 2;
+  for (size_t idx = 1; idx < spec.pieces.size(); ++idx)
+    spec.size *= 64;
+  return true;
+}
+
+// Moves the white king into the triangle. Placements with the king on the
+// a1-d4 diagonal keep their mirror image along it as a separate entry.
+static void normalise(const spec_t &spec, squares_t &squares) noexcept {
+  const size_t num_pieces = spec.pieces.size();
+  const auto transform = [&](int (*map)(int)) {
+    for (size_t idx = 0; idx < num_pieces; ++idx)
+      squares[idx] = map(squares[idx]);
+  };
+  if (squares[0] % 8 > 3)
+    transform([](const int sq) { return sq ^ 7; });
+  if (squares[0] / 8 > 3)
+    transform([](const int sq) { return sq ^ 56; });
+  if (squares[0] / 8 > squares[0] % 8)
+    transform(transpose);
+}
+
+static size_t index_of(const spec_t &spec, squares_t squares, const bool side) noexcept {
+  normalise(spec, squares);
+  size_t result = std::find(triangle_squares, triangle_squares + 10, squares[0]) - triangle_squares;
+  ASSERT(result < 10);
+  for (size_t idx = 1; idx < spec.pieces.size(); ++idx)
+    result = 64 * result + squares[idx];
+  return 2 * result + side;
+}
+
+static void placement_of(const spec_t &spec, size_t index, squares_t &squares,
+  bool &side) noexcept {
+  side = index % 2;
+  index /= 2;
+  for (size_t idx = spec.pieces.size() - 1; idx > 0; --idx) {
+    squares[idx] = index % 64;
+    index /= 64;
+  }
+  squares[0] = triangle_squares[index];
+}
+
+// The squares of spec's pieces on board, with the colours swapped (and the
+// board mirrored) if flip
+static void squares_on(const Board &board, const spec_t &spec, const bool flip,
+  squares_t &squares) noexcept {
+  std::array<unsigned, 16> seen = {};
+  for (size_t idx = 0; idx < spec.pieces.size(); ++idx) {
+    const piece_t piece = flip ? spec.pieces[idx] ^ 8u : spec.pieces[idx];
+    const square_t sq = board.m_positions[piece][seen[piece]++];
+    const int sq64 = get_square_64_rc(get_square_row(sq), get_square_col(sq));
+    squares[idx] = flip ? sq64 ^ 56 : sq64;
+  }
+}
+
+// Whether side attacks the piece on squares[target], ignoring the piece at
+// index removed (just captured). Boards must not be built for illegal
+// placements, and are slow to build, so generation works on squares alone.
+static bool attacked(const spec_t &spec, const squares_t &squares, const size_t target,
+  const int side, const uint64_t occupied, const size_t removed) noexcept {
+  const int target_row = squares[target] / 8, target_col = squares[target] % 8;
+  for (size_t idx = 0; idx < spec.pieces.size(); ++idx) {
+    const piece_t piece = spec.pieces[idx];
+    if ((piece >> 3) != side || idx == removed)
+      continue;
+    const int row_gap = target_row - squares[idx] / 8, col_gap = target_col - squares[idx] % 8;
+    const int rows = std::abs(row_gap), cols = std::abs(col_gap);
+    const piece_t type = piece & 7u;
+    if (type == WHITE_KING && std::max(rows, cols) == 1)
+      return true;
+    if (type == WHITE_KNIGHT && rows * cols == 2)
+      return true;
+    const bool straight = (rows == 0) != (cols == 0), diagonal = rows == cols && rows > 0;
+    if (!((type == WHITE_QUEEN && (straight || diagonal)) || (type == WHITE_ROOK && straight)
+        || (type == WHITE_BISHOP && diagonal)))
+      continue;
+    const int step = 8 * ((row_gap > 0) - (row_gap < 0)) + ((col_gap > 0) - (col_gap < 0));
+    int sq = squares[idx] + step;
+    while (sq != squares[target] && !((occupied >> sq) & 1))
+      sq += step;
+    if (sq == squares[target])
+      return true;
+  }
+  return false;
+}
+
+static std::string fen_of(const spec_t &spec, const squares_t &squares, const bool side) noexcept {
+  char grid[64];
+  std::fill(grid, grid + 64, '.');
+  for (size_t idx = 0; idx < spec.pieces.size(); ++idx)
+    grid[squares[idx]] = char_from_piece(spec.pieces[idx]);
+  std::string result;
+  for (int row = 7; row >= 0; --row) {
+    int empty = 0;
+    for (int col = 0; col < 8; ++col) {
+      const char chr = grid[8 * row + col];
+      if (chr == '.') {
+        empty++;
+        continue;
+      }
+      if (empty > 0)
+        result += char('0' + empty);
+      result += chr;
+      empty = 0;
+    }
+    if (empty > 0)
+      result += char('0' + empty);
+    if (row > 0)
+      result += '/';
+  }
+  return result + (side == WHITE ? " w" : " b") + " - - 0 1";
+}
+
+// Runs callback(start, end) over slices of [0, size), one per thread
+template <typename F>
+static void parallel_for(const size_t size, const unsigned num_threads, F &&callback) noexcept {
+  const unsigned threads = std::max(1u, num_threads);
+  const size_t stride = size / threads;
+  std::vector<std::thread> workers;
+  for (unsigned idx = 1; idx < threads; ++idx) {
+    const size_t start = stride * idx;
+    const size_t end = (idx + 1 == threads) ? size : start + stride;
+    workers.emplace_back([&callback, start, end] { callback(start, end); });
+  }
+  callback(0, (threads == 1) ? size : stride);
+  for (auto &worker : workers)
+    worker.join();
+}
+
+/*
+FILES:
+A header of uint32_t {FILE_MAGIC, FILE_VERSION, BLOCK_SIZE, number of blocks},
+the uint64_t number of entries, then number of blocks + 1 uint64_t offsets of
+the blocks from the start of the data, then the data: each block is a list of
+(run length, value) byte pairs. Native byte order.
+*/
+class TableFile {
+  const uint8_t *m_map = nullptr;
+  size_t m_map_size = 0;
+  const uint64_t *m_offsets = nullptr;
+  const uint8_t *m_data = nullptr;
+  size_t m_entries = 0;
+
+public:
+  TableFile() = default;
+  TableFile(const TableFile &) = delete;
+  TableFile &operator=(const TableFile &) = delete;
+  ~TableFile() noexcept {
+    if (m_map != nullptr)
+      munmap(const_cast<uint8_t *>(m_map), m_map_size);
+  }
+
+  bool open(const std::string &path) noexcept {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return false;
+    struct stat info;
+    const bool ok = fstat(fd, &info) == 0 && info.st_size > 0;
+    void *const map = ok ? mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+    ::close(fd);
+    if (map == MAP_FAILED)
+      return false;
+    m_map = static_cast<const uint8_t *>(map);
+    m_map_size = info.st_size;
+
+    const size_t header_size = 4 * sizeof(uint32_t) + sizeof(uint64_t);
+    if (m_map_size < header_size)
+      return false;
+    uint32_t header[4];
+    uint64_t entries;
+    std::copy(m_map, m_map + sizeof(header), reinterpret_cast<uint8_t *>(header));
+    std::copy(m_map + sizeof(header), m_map + header_size, reinterpret_cast<uint8_t *>(&entries));
+    const size_t num_blocks = header[3];
+    const size_t data_start = header_size + (num_blocks + 1) * sizeof(uint64_t);
+    if (header[0] != FILE_MAGIC || header[1] != FILE_VERSION || header[2] != BLOCK_SIZE
+      || num_blocks != (entries + BLOCK_SIZE - 1) / BLOCK_SIZE || m_map_size < data_start)
+      return false;
+    // Offsets are 8-byte aligned, as the header is 24 bytes
+    m_offsets = reinterpret_cast<const uint64_t *>(m_map + header_size);
+    m_data = m_map + data_start;
+    m_entries = entries;
+    return m_offsets[num_blocks] == m_map_size - data_start;
+  }
+
+  inline size_t entries() const noexcept { return m_entries; }
+
+  uint8_t get(const size_t index) const noexcept {
+    ASSERT(index < m_entries);
+    const size_t block = index / BLOCK_SIZE;
+    size_t remaining = index % BLOCK_SIZE;
+    const uint8_t *run = m_data + m_offsets[block];
+    while (remaining >= run[0]) {
+      remaining -= run[0];
+      run += 2;
+    }
+    return run[1];
+  }
+
+  std::vector<uint8_t> read_all() const noexcept {
+    std::vector<uint8_t> result;
+    result.reserve(m_entries);
+    const uint8_t *run = m_data, *const end = m_data + m_offsets[(m_entries + BLOCK_SIZE - 1) / BLOCK_SIZE];
+    for (; run < end; run += 2)
+      result.insert(result.end(), run[0], run[1]);
+    return result;
+  }
+};
+
+static bool write_table(const std::string &path, const std::vector<uint8_t> &values) noexcept {
+  const uint32_t num_blocks = (values.size() + BLOCK_SIZE - 1) / BLOCK_SIZE;
+  std::vector<uint64_t> offsets = {0};
+  std::vector<uint8_t> data;
+  for (size_t start = 0; start < values.size(); start += BLOCK_SIZE) {
+    const size_t end = std::min<size_t>(start + BLOCK_SIZE, values.size());
+    for (size_t idx = start; idx < end;) {
+      size_t length = 1;
+      while (idx + length < end && values[idx + length] == values[idx] && length < 255)
+        length++;
+      data.push_back(length);
+      data.push_back(values[idx]);
+      idx += length;
+    }
+    offsets.push_back(data.size());
+  }
+
+  std::ofstream out(path, std::ios::binary);
+  const uint32_t header[4] = {FILE_MAGIC, FILE_VERSION, BLOCK_SIZE, num_blocks};
+  const uint64_t entries = values.size();
+  return out
+    && out.write(reinterpret_cast<const char *>(header), sizeof(header))
+    && out.write(reinterpret_cast<const char *>(&entries), sizeof(entries))
+    && out.write(reinterpret_cast<const char *>(offsets.data()), offsets.size() * sizeof(uint64_t))
+    && out.write(reinterpret_cast<const char *>(data.data()), data.size());
+}
+
+// Names of the tables reachable from spec by one capture
+static std::vector<std::string> dependencies(const spec_t &spec) noexcept {
+  const size_t split = spec.name.find('v');
+  const std::string white = spec.name.substr(0, split), black = spec.name.substr(split + 1);
+  std::vector<std::string> result;
+  for (size_t idx = 1; idx < spec.name.size(); ++idx) {
+    if (idx == split || idx == split + 1)
+      continue;
+    const std::string remaining_white = (idx < split) ? white.substr(0, idx) + white.substr(idx + 1) : white;
+    const std::string remaining_black = (idx > split)
+      ? black.substr(0, idx - split - 1) + black.substr(idx - split) : black;
+    bool flip;
+    const std::string name = canonical_name(remaining_white, remaining_black, flip);
+    if (name != "KvK" && std::find(result.begin(), result.end(), name) == result.end())
+      result.push_back(name);
+  }
+  return result;
+}
+
+// Steps of each piece type in 64-square form, as (row, column) pairs; sliders
+// repeat them
+constexpr int king_steps[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}};
+constexpr int knight_steps[8][2] = {{-2, -1}, {-2, 1}, {-1, -2}, {-1, 2}, {1, -2}, {1, 2}, {2, -1}, {2, 1}};
+constexpr int rook_steps[4][2] = {{-1, 0}, {0, -1}, {0, 1}, {1, 0}};
+constexpr int bishop_steps[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+
+// Calls callback(to) for every square the piece on from reaches, including
+// occupied ones, which end a slide
+template <typename F>
+static void for_each_target(const piece_t type, const int from, const uint64_t occupied,
+  F &&callback) noexcept {
+  const auto walk = [&](const int (*steps)[2], const int num_steps, const bool slides) {
+    for (int idx = 0; idx < num_steps; ++idx) {
+      int row = from / 8 + steps[idx][0], col = from % 8 + steps[idx][1];
+      for (; 0 <= row && row < 8 && 0 <= col && col < 8; row += steps[idx][0], col += steps[idx][1]) {
+        callback(8 * row + col);
+        if (!slides || ((occupied >> (8 * row + col)) & 1))
+          break;
+      }
+    }
+  };
+  switch (type) {
+    case WHITE_KING: walk(king_steps, 8, false); break;
+    case WHITE_KNIGHT: walk(knight_steps, 8, false); break;
+    case WHITE_ROOK: walk(rook_steps, 4, true); break;
+    case WHITE_BISHOP: walk(bishop_steps, 4, true); break;
+    case WHITE_QUEEN: walk(rook_steps, 4, true); walk(bishop_steps, 4, true); break;
+    default: ASSERT_MSG(0, "No pawns in tables (%u)", type);
+  }
+}
+
+using finished_tables_t = std::map<std::string, std::vector<uint8_t>>;
+
+class Generator {
+  // The table reached by capturing each piece: its spec, whether colours swap,
+  // and where each of its pieces was in this table
+  struct exit_t {
+    spec_t spec;
+    bool flip = false;
+    std::vector<size_t> order;
+    const std::vector<uint8_t> *values = nullptr;
+  };
+
+  const spec_t &m_spec;
+  const unsigned m_threads;
+  size_t m_black_king;
+  std::vector<exit_t> m_exits;
+  std::vector<std::atomic<uint8_t>> m_values;
+  // The passes in which a capture could win or lose a position (0 for none),
+  // and whether a successor was resolved in the last pass
+  std::vector<std::array<uint8_t, 2>> m_exit_plies;
+  std::vector<std::atomic<uint8_t>> m_marked;
+
+  inline uint64_t occupancy(const squares_t &squares) const noexcept {
+    uint64_t result = 0;
+    for (size_t idx = 0; idx < m_spec.pieces.size(); ++idx)
+      result |= uint64_t(1) << squares[idx];
+    return result;
+  }
+
+  // Calls callback(value) with the value of each legal move's result, and
+  // whether the move captures. Returns the number of legal moves.
+  template <typename F>
+  int for_each_successor(const squares_t &squares, const bool side, F &&callback) const noexcept {
+    const size_t num_pieces = m_spec.pieces.size();
+    const uint64_t occupied = occupancy(squares);
+    const size_t own_king = (side == WHITE) ? 0 : m_black_king;
+    int num_moves = 0;
+    for (size_t idx = 0; idx < num_pieces; ++idx) {
+      const piece_t piece = m_spec.pieces[idx];
+      if ((piece >> 3) != side)
+        continue;
+      const int from = squares[idx];
+      for_each_target(piece & 7u, from, occupied, [&](const int to) {
+        size_t captured = num_pieces;
+        if ((occupied >> to) & 1) {
+          captured = std::find(squares.begin(), squares.begin() + num_pieces, to) - squares.begin();
+          if ((m_spec.pieces[captured] >> 3) == side || (m_spec.pieces[captured] & 7u) == WHITE_KING)
+            return;
+        }
+        squares_t next = squares;
+        next[idx] = to;
+        const uint64_t next_occupied = (occupied & ~(uint64_t(1) << from)) | (uint64_t(1) << to);
+        if (attacked(m_spec, next, own_king, !side, next_occupied, captured))
+          return;
+        num_moves++;
+        if (captured == num_pieces) {
+          callback(m_values[index_of(m_spec, next, !side)].load(std::memory_order_relaxed), false);
+          return;
+        }
+        const exit_t &exit = m_exits[captured];
+        if (exit.values == nullptr) {
+          callback(DRAW, true);
+          return;
+        }
+        squares_t reduced;
+        for (size_t pos = 0; pos < exit.order.size(); ++pos)
+          reduced[pos] = exit.flip ? next[exit.order[pos]] ^ 56 : next[exit.order[pos]];
+        callback((*exit.values)[index_of(exit.spec, reduced, exit.flip ? side : !side)], true);
+      });
+    }
+    return num_moves;
+  }
+
+  void initialise(const size_t index) noexcept {
+    squares_t squares;
+    bool side;
+    placement_of(m_spec, index, squares, side);
+    m_values[index] = INVALID;
+    // Overlapping pieces, touching kings, or the side not to move in check
+    const uint64_t occupied = occupancy(squares);
+    const int row_gap = std::abs(squares[0] / 8 - squares[m_black_king] / 8),
+      col_gap = std::abs(squares[0] % 8 - squares[m_black_king] % 8);
+    if (__builtin_popcountll(occupied) != (int)m_spec.pieces.size() || std::max(row_gap, col_gap) <= 1
+      || attacked(m_spec, squares, (side == WHITE) ? m_black_king : 0, side, occupied, MAX_PIECES))
+      return;
+
+    // A capture reaching a loss wins right after it, and the last capture
+    // reaching a win may lose once the other moves are resolved
+    bool can_lose = true;
+    int win_ply = MAX_DTM + 1, loss_ply = 0;
+    const int num_moves = for_each_successor(squares, side, [&](const uint8_t value, const bool capture) {
+      const int dtm = value - MATED;
+      if (!capture)
+        return;
+      if (value >= MATED && dtm % 2 == 0)
+        win_ply = std::min(win_ply, dtm + 1);
+      else if (value >= MATED)
+        loss_ply = std::max(loss_ply, dtm + 1);
+      else
+        can_lose = false;
+    });
+    m_exit_plies[index] = {uint8_t((win_ply <= MAX_DTM) ? win_ply : 0),
+      uint8_t(can_lose ? loss_ply : 0)};
+    const size_t own_king = (side == WHITE) ? 0 : m_black_king;
+    const bool in_check = attacked(m_spec, squares, own_king, !side, occupied, MAX_PIECES);
+    m_values[index] = (num_moves == 0 && in_check) ? MATED : DRAW;
+  }
+
+  void mark_predecessors(const size_t index) noexcept {
+    squares_t squares;
+    bool side;
+    placement_of(m_spec, index, squares, side);
+    const Board board(fen_of(m_spec, squares, side));
+    for (const move_t move : board.unmoves()) {
+      const square_t from = move_from(move), to = move_to(move);
+      const int from64 = get_square_64_rc(get_square_row(from), get_square_col(from)),
+        to64 = get_square_64_rc(get_square_row(to), get_square_col(to));
+      squares_t previous = squares;
+      *std::find(previous.begin(), previous.begin() + m_spec.pieces.size(), to64) = from64;
+      normalise(m_spec, previous);
+      m_marked[index_of(m_spec, previous, !side)].store(1, std::memory_order_relaxed);
+      // The mirror image is also a predecessor, of this position's mirror image
+      if (previous[0] / 8 == previous[0] % 8) {
+        for (size_t idx = 0; idx < m_spec.pieces.size(); ++idx)
+          previous[idx] = transpose(previous[idx]);
+        m_marked[index_of(m_spec, previous, !side)].store(1, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Resolves index in pass ply: won if some move reaches a position lost in
+  // ply - 1, lost if every move reaches a position won in fewer than ply
+  bool resolve(const size_t index, const int ply) noexcept {
+    squares_t squares;
+    bool side;
+    placement_of(m_spec, index, squares, side);
+    bool wins = false, all_won = true;
+    const int num_moves = for_each_successor(squares, side, [&](const uint8_t value, const bool) {
+      const int dtm = value - MATED;
+      wins |= value >= MATED && dtm % 2 == 0 && dtm == ply - 1;
+      all_won &= value >= MATED && dtm % 2 == 1 && dtm < ply;
+    });
+    // Stalemates may be marked, through moves that are not legal
+    if (!wins && (num_moves == 0 || !all_won))
+      return false;
+    m_values[index].store(MATED + ply, std::memory_order_relaxed);
+    return true;
+  }
+
+public:
+  Generator(const spec_t &spec, const finished_tables_t &finished, const unsigned threads) noexcept
+    : m_spec(spec), m_threads(threads), m_exits(spec.pieces.size()), m_values(spec.size),
+      m_exit_plies(spec.size), m_marked(spec.size) {
+    m_black_king = std::find(spec.pieces.begin(), spec.pieces.end(), BLACK_KING) - spec.pieces.begin();
+    for (size_t captured = 0; captured < spec.pieces.size(); ++captured) {
+      if ((spec.pieces[captured] & 7u) == WHITE_KING)
+        continue;
+      std::string letters[2];
+      std::vector<size_t> sides[2];
+      for (size_t idx = 0; idx < spec.pieces.size(); ++idx) {
+        if (idx == captured)
+          continue;
+        letters[spec.pieces[idx] >> 3] += char_from_piece(spec.pieces[idx] & 7u);
+        sides[spec.pieces[idx] >> 3].push_back(idx);
+      }
+      exit_t &exit = m_exits[captured];
+      const std::string name = canonical_name(letters[WHITE], letters[BLACK], exit.flip);
+      if (name == "KvK")
+        continue;
+      parse_name(name, exit.spec);
+      exit.order = exit.flip ? sides[BLACK] : sides[WHITE];
+      const std::vector<size_t> &second = exit.flip ? sides[WHITE] : sides[BLACK];
+      exit.order.insert(exit.order.end(), second.begin(), second.end());
+      exit.values = &finished.at(name);
+    }
+  }
+
+  std::vector<uint8_t> run() noexcept {
+    const size_t size = m_spec.size;
+    parallel_for(size, m_threads, [&](const size_t start, const size_t end) {
+      for (size_t index = start; index < end; ++index)
+        initialise(index);
+    });
+
+    // Captures may lead to mates as long as the longest in the other tables
+    int longest_exit = 0;
+    for (const exit_t &exit : m_exits)
+      if (exit.values != nullptr)
+        for (const uint8_t value : *exit.values)
+          longest_exit = std::max(longest_exit, value - MATED);
+
+    for (int ply = 1; ply <= MAX_DTM; ++ply) {
+      parallel_for(size, m_threads, [&](const size_t start, const size_t end) {
+        for (size_t index = start; index < end; ++index)
+          if (m_values[index].load(std::memory_order_relaxed) == MATED + ply - 1)
+            mark_predecessors(index);
+      });
+      std::atomic<size_t> resolved(0);
+      parallel_for(size, m_threads, [&](const size_t start, const size_t end) {
+        size_t count = 0;
+        for (size_t index = start; index < end; ++index) {
+          const bool marked = m_marked[index].exchange(0, std::memory_order_relaxed);
+          const bool exit = m_exit_plies[index][0] == ply || m_exit_plies[index][1] == ply;
+          if ((marked || exit) && m_values[index].load(std::memory_order_relaxed) == DRAW)
+            count += resolve(index, ply);
+        }
+        resolved += count;
+      });
+      if (resolved == 0 && ply > longest_exit + 1)
+        break;
+    }
+
+    std::vector<uint8_t> result(size);
+    for (size_t index = 0; index < size; ++index)
+      result[index] = m_values[index].load(std::memory_order_relaxed);
+    return result;
+  }
+};
+
+static std::string path_of(const std::string &dir, const std::string &name) noexcept {
+  return (std::filesystem::path(dir) / (name + ".pctb")).string();
+}
+
+static bool generate_into(const spec_t &spec, const std::string &dir, const unsigned threads,
+  finished_tables_t &finished) noexcept {
+  for (const std::string &name : dependencies(spec)) {
+    if (finished.count(name) > 0)
+      continue;
+    TableFile file;
+    if (file.open(path_of(dir, name))) {
+      finished[name] = file.read_all();
+      continue;
+    }
+    spec_t dependency;
+    if (!parse_name(name, dependency) || !generate_into(dependency, dir, threads, finished))
+      return false;
+  }
+  std::vector<uint8_t> values = Generator(spec, finished, threads).run();
+  const bool ok = write_table(path_of(dir, spec.name), values);
+  finished[spec.name] = std::move(values);
+  return ok;
+}
+
+bool valid_name(const std::string &name) noexcept {
+  spec_t spec;
+  return parse_name(name, spec);
+}
+
+bool generate(const std::string &name, const std::string &dir, const unsigned threads) noexcept {
+  spec_t spec;
+  if (!parse_name(name, spec))
+    return false;
+  finished_tables_t finished;
+  return generate_into(spec, dir, threads, finished);
+}
+
+struct loaded_table_t {
+  spec_t spec;
+  TableFile file;
+};
+
+// Written only by init and release, which must not run alongside probes
+static std::map<std::string, std::unique_ptr<loaded_table_t>> loaded_tables;
+static int loaded_max_pieces = 0;
+
+size_t init(const std::string &dir) noexcept {
+  std::error_code error;
+  for (const auto &entry : std::filesystem::directory_iterator(dir, error)) {
+    const std::filesystem::path &path = entry.path();
+    auto table = std::make_unique<loaded_table_t>();
+    if (path.extension() != ".pctb" || !parse_name(path.stem().string(), table->spec)
+      || !table->file.open(path.string()) || table->file.entries() != table->spec.size)
+      continue;
+    loaded_max_pieces = std::max(loaded_max_pieces, (int)table->spec.pieces.size());
+    loaded_tables[table->spec.name] = std::move(table);
+  }
+  return loaded_tables.size();
+}
+
+void release() noexcept {
+  loaded_tables.clear();
+  loaded_max_pieces = 0;
+}
+
+int max_pieces() noexcept {
+  return loaded_max_pieces;
+}
+
+std::string table_name(const Board &board) noexcept {
+  const std::string white = side_letters(board, WHITE), black = side_letters(board, BLACK);
+  bool flip;
+  if (white.empty() || black.empty() || white.size() + black.size() > MAX_PIECES
+    || white.size() + black.size() < 3)
+    return "";
+  return canonical_name(white, black, flip);
+}
+
+bool probe(const Board &board, probe_result_t &result) noexcept {
+  if (loaded_max_pieces == 0 || board.m_castle_state != 0)
+    return false;
+  int num_pieces = 0;
+  for (const unsigned count : board.m_num_pieces)
+    num_pieces += count;
+  if (num_pieces > loaded_max_pieces)
+    return false;
+
+  const std::string white = side_letters(board, WHITE), black = side_letters(board, BLACK);
+  if (white.empty() || black.empty())
+    return false;
+  bool flip;
+  const auto it = loaded_tables.find(canonical_name(white, black, flip));
+  if (it == loaded_tables.end())
+    return false;
+  const loaded_table_t &table = *it->second;
+  squares_t squares;
+  squares_on(board, table.spec, flip, squares);
+  const bool side = flip ? !board.m_next_move_colour : board.m_next_move_colour;
+  const uint8_t value = table.file.get(index_of(table.spec, squares, side));
+  if (value == INVALID)
+    return false;
+  result.dtm = (value == DRAW) ? 0 : value - MATED;
+  result.wdl = (value == DRAW) ? TB_DRAW : (result.dtm % 2 == 1) ? TB_WIN : TB_LOSS;
+  // The table ignores the move counter, so a mate it cannot be sure of
+  // reaching before the game is drawn is left to the search
+  return result.wdl == TB_DRAW || board.m_fifty_move + result.dtm <= MAX_FIFTY_MOVE;
+}
+
+} // namespace tb
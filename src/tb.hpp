@@ -0,0 +1,70 @@
+
+#ifndef TB_H
+#define TB_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "defs.hpp"
+#include "board.hpp"
+
+/*
+ENDGAME TABLEBASES:
+Distance-to-mate tables for pawnless endgames of up to MAX_PIECES pieces,
+generated by retrograde analysis.
+- Tables are named after their material, stronger side first, e.g. "KRvKB".
+  Positions where black is stronger are probed with the colours swapped.
+- The index is perfect over piece placements: the white king is moved into the
+  a1-d1-d4 triangle by the symmetries of the board, then every other piece
+  takes one of 64 squares, then the side to move. Illegal placements get
+  their own (invalid) entries.
+- Each entry is a byte: 0 for invalid, 1 for a draw, otherwise 2 plus the
+  distance to mate in plies, which is odd when the side to move wins.
+- Generation starts from the mates and from moves out of the table (captures),
+  then walks backwards with Board::unmoves, one ply per pass, with the passes
+  split across threads. Tables reached by captures are generated first.
+- Files are split into blocks of BLOCK_SIZE entries, each run-length encoded,
+  and are memory-mapped when loaded; a probe decodes one block.
+*/
+
+namespace tb {
+
+enum { MAX_PIECES = 5, BLOCK_SIZE = 1024 };
+enum WDL { TB_LOSS = -1, TB_DRAW = 0, TB_WIN = 1 };
+
+struct probe_result_t {
+  int wdl = TB_DRAW;
+  // Plies to mate with best play, for the side to move
+  int dtm = 0;
+};
+
+// The table covering board's material, or empty if there is none: pawns, too
+// many pieces, or a bare king on either side
+std::string table_name(const Board &board) noexcept;
+
+// Whether name is a table that can be generated, such as "KRvK"
+bool valid_name(const std::string &name) noexcept;
+
+// Generates the table called name into dir as <name>.pctb, along with every
+// table it depends on that is not already there. False on a bad name or a
+// failed write.
+bool generate(const std::string &name, const std::string &dir,
+  const unsigned threads = 1) noexcept;
+
+// Maps every table file in dir, returning the number of tables loaded
+size_t init(const std::string &dir) noexcept;
+void release() noexcept;
+// The most pieces in any loaded table, 0 when none are loaded
+int max_pieces() noexcept;
+
+// Whether board is covered by a loaded table, in which case result is set.
+// Positions with castling rights are never covered, and neither are wins or
+// losses whose mate would come after the fifty move rule draws the game:
+// m_fifty_move + dtm past MAX_FIFTY_MOVE. A capture on the way to mate would
+// reset the counter, but the table does not say whether there is one.
+bool probe(const Board &board, probe_result_t &result) noexcept;
+
+} // namespace tb
+
+#endif /* end of include guard: TB_H */
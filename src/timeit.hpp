@@ -1,4 +1,7 @@
 
+#ifndef TIMEIT_H
+#define TIMEIT_H
+
 #include <chrono>
 
 template <typename Func, typename ... Args>
@@ -8,3 +11,17 @@ size_t timeit(Func f, Args&&... args) {
   const auto finish = std::chrono::high_resolution_clock::now();
   return std::chrono::duration_cast<std::chrono::nanoseconds>(finish-start).count();
 }
+
+// Makes the compiler assume value is read, so that computing it is not
+// optimised away in a benchmark
+template <typename T>
+inline void do_not_optimize(const T &value) {
+  asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Makes the compiler assume all memory is read and written
+inline void clobber_memory() {
+  asm volatile("" : : : "memory");
+}
+
+#endif /* end of include guard: TIMEIT_H */
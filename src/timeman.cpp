@@ -0,0 +1,52 @@
+
+#include "timeman.hpp"
+
+#include <algorithm>
+
+time_budget_t allocate_time(const time_control_t &clock) noexcept {
+  time_budget_t budget;
+  if (clock.time_ms == 0)
+    return budget;
+  const size_t usable = clock.time_ms > MOVE_OVERHEAD_MS ? clock.time_ms - MOVE_OVERHEAD_MS : 1;
+  const size_t moves = clock.moves_to_go > 0 ? clock.moves_to_go : (size_t)DEFAULT_MOVES_TO_GO;
+  // An even share of the remaining time, and most of the increment, but
+  // never so much that the next moves are left short
+  const size_t share = usable / moves + clock.increment_ms * 3 / 4;
+  const size_t most = (moves == 1) ? usable : usable * 3 / 4;
+  budget.soft_ms = std::max<size_t>(1, std::min(share, most));
+  budget.hard_ms = std::max<size_t>(1, std::min(share * HARD_LIMIT_RATIO, most));
+  return budget;
+}
+
+void TimeManager::start(const time_budget_t &budget) noexcept {
+  m_budget = budget;
+  m_best_move = NULL_MOVE;
+  m_last_score = 0;
+  m_score_drop = 0;
+  m_stable_iterations = 0;
+  m_instability = 0.0;
+}
+
+size_t TimeManager::soft_ms() const noexcept {
+  // Up to a fifth more while the best move is new, a fifth less once it has
+  // held for five iterations
+  double scale = 1.2 - 0.08 * std::min(m_stable_iterations, 5);
+  scale *= 1.0 + 0.5 * m_instability;
+  scale *= 1.0 + std::min(m_score_drop, 200) / 400.0;
+  return std::min<size_t>(m_budget.soft_ms * scale, m_budget.hard_ms);
+}
+
+bool TimeManager::should_continue(const move_t best_move, const int score,
+  const size_t elapsed_ms) noexcept {
+  m_instability /= 2;
+  if (m_best_move == NULL_MOVE || best_move == m_best_move) {
+    m_stable_iterations++;
+  } else {
+    m_stable_iterations = 0;
+    m_instability += 1.0;
+  }
+  m_score_drop = (m_best_move == NULL_MOVE) ? 0 : std::max(0, m_last_score - score);
+  m_best_move = best_move;
+  m_last_score = score;
+  return m_budget.soft_ms == 0 || elapsed_ms < soft_ms();
+}
@@ -0,0 +1,64 @@
+
+#ifndef TIMEMAN_H
+#define TIMEMAN_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "defs.hpp"
+#include "move.hpp"
+
+/*
+TIME MANAGEMENT:
+The remaining time and increment are turned into two deadlines per move:
+- The soft deadline is checked between iterations of the search. It is
+  stretched while the best move keeps changing or the score is falling, and
+  shrunk once the best move has been stable for a while.
+- The hard deadline is checked inside the search, every CHECK_NODES nodes, and
+  is never exceeded by more than a few milliseconds.
+*/
+
+struct time_control_t {
+  size_t time_ms = 0; // On the clock of the side to move, 0 when untimed
+  size_t increment_ms = 0;
+  size_t moves_to_go = 0; // Until the next time control, 0 for the whole game
+};
+
+struct time_budget_t {
+  size_t soft_ms = 0, hard_ms = 0;
+};
+
+enum {
+  // Kept back from the clock for communication delays
+  MOVE_OVERHEAD_MS = 30,
+  // The number of moves the remaining time is split over without movestogo
+  DEFAULT_MOVES_TO_GO = 30,
+  // The hard deadline is at most this many soft deadlines
+  HARD_LIMIT_RATIO = 4,
+  // Nodes between two looks at the clock
+  CHECK_NODES = 1024,
+};
+
+time_budget_t allocate_time(const time_control_t &clock) noexcept;
+
+class TimeManager {
+  time_budget_t m_budget;
+  move_t m_best_move = NULL_MOVE;
+  int m_last_score = 0;
+  // How far the score fell in the last iteration, in centipawns
+  int m_score_drop = 0;
+  // Iterations in a row with the same best move
+  int m_stable_iterations = 0;
+  // Recent best move changes, halved every iteration
+  double m_instability = 0.0;
+
+public:
+  void start(const time_budget_t &budget) noexcept;
+  // After each completed iteration: whether another one is worth starting
+  bool should_continue(const move_t best_move, const int score, const size_t elapsed_ms) noexcept;
+  // The soft deadline, as currently stretched
+  size_t soft_ms() const noexcept;
+  inline size_t hard_ms() const noexcept { return m_budget.hard_ms; }
+};
+
+#endif /* end of include guard: TIMEMAN_H */
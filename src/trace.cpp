@@ -0,0 +1,150 @@
+
+#include "trace.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+  #include <x86intrin.h>
+  #define TRACE_HAS_TSC 1
+#else
+  #define TRACE_HAS_TSC 0
+#endif
+
+namespace trace {
+
+struct buffer_t {
+  std::array<event_t, BUFFER_SIZE> events;
+  // Events ever written, only advanced by the owning thread
+  std::atomic<uint64_t> head{0};
+};
+
+static std::mutex registry_mutex;
+static std::vector<std::unique_ptr<buffer_t>> buffers;
+// Buffers of threads that have exited, handed to new threads so that
+// short-lived search threads do not each keep a buffer. Their events are
+// kept until overwritten.
+static std::vector<buffer_t *> free_buffers;
+static uint32_t next_thread = 0;
+
+struct thread_buffer_t {
+  buffer_t *buffer;
+  uint32_t thread;
+
+  thread_buffer_t() noexcept {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    if (free_buffers.empty()) {
+      buffers.push_back(std::make_unique<buffer_t>());
+      buffer = buffers.back().get();
+    } else {
+      buffer = free_buffers.back();
+      free_buffers.pop_back();
+    }
+    thread = next_thread++;
+  }
+  ~thread_buffer_t() noexcept {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    free_buffers.push_back(buffer);
+  }
+};
+
+static inline uint64_t clock_ns() noexcept {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint64_t now() noexcept {
+#if TRACE_HAS_TSC
+  return __rdtsc();
+#else
+  return clock_ns();
+#endif
+}
+
+// Ticks and nanoseconds at startup, to convert ticks to time
+struct origin_t {
+  uint64_t ticks, ns;
+};
+
+static const origin_t origin = {now(), clock_ns()};
+
+void record(const char *name, const uint64_t start, const uint64_t end, const uint64_t arg) noexcept {
+  thread_local thread_buffer_t local;
+  buffer_t &buffer = *local.buffer;
+  const uint64_t head = buffer.head.load(std::memory_order_relaxed);
+  buffer.events[head & (BUFFER_SIZE - 1)] = {name, start, end, arg, local.thread};
+  buffer.head.store(head + 1, std::memory_order_release);
+}
+
+// Every buffer's surviving events, oldest first per buffer. The events are
+// copied unsynchronised, hence no thread may be recording.
+static std::vector<event_t> collect() noexcept {
+  std::vector<event_t> result;
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  for (const auto &buffer : buffers) {
+    const uint64_t head = buffer->head.load(std::memory_order_acquire);
+    for (uint64_t idx = head - std::min<uint64_t>(head, BUFFER_SIZE); idx < head; ++idx)
+      result.push_back(buffer->events[idx & (BUFFER_SIZE - 1)]);
+  }
+  return result;
+}
+
+size_t num_events() noexcept {
+  size_t result = 0;
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  for (const auto &buffer : buffers)
+    result += std::min<uint64_t>(buffer->head.load(std::memory_order_acquire), BUFFER_SIZE);
+  return result;
+}
+
+void clear() noexcept {
+  // Owners load and store their head without a lock, so a thread still
+  // recording would overwrite this reset
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  for (const auto &buffer : buffers)
+    buffer->head.store(0, std::memory_order_release);
+}
+
+void dump_chrome(std::ostream &out) noexcept {
+  const std::vector<event_t> events = collect();
+  // Ticks per microsecond, measured over the whole run so far and over at
+  // least a few milliseconds
+  while (clock_ns() - origin.ns < 5000000)
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  const uint64_t ticks = now(), ns = clock_ns();
+  const double ticks_per_us = (ticks - origin.ticks) * 1000.0 / (ns - origin.ns);
+  const auto micros = [&](const uint64_t tick) {
+    return ((int64_t)(tick - origin.ticks)) / ticks_per_us;
+  };
+
+  out << "{\"traceEvents\":[" << std::fixed << std::setprecision(3);
+  for (size_t idx = 0; idx < events.size(); ++idx) {
+    const event_t &event = events[idx];
+    out << (idx > 0 ? ",\n" : "\n") << "{\"name\":\"" << event.name << "\",\"pid\":1,\"tid\":" << event.thread
+      << ",\"ts\":" << micros(event.start);
+    if (event.end == event.start)
+      out << ",\"ph\":\"i\",\"s\":\"t\"";
+    else
+      out << ",\"ph\":\"X\",\"dur\":" << (event.end - event.start) / ticks_per_us;
+    out << ",\"args\":{\"arg\":" << event.arg << "}}";
+  }
+  out << "\n]}\n" << std::defaultfloat;
+}
+
+bool dump_chrome(const std::string &file_name) noexcept {
+  std::ofstream file(file_name);
+  if (!file)
+    return false;
+  dump_chrome(file);
+  return (bool)file;
+}
+
+} // namespace trace
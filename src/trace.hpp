@@ -0,0 +1,96 @@
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/*
+TRACING:
+Timed events, compiled in up to TRACE_LEVEL (make TRACE=<level>):
+- 0: nothing, every TRACE_ macro expands to nothing (the default)
+- 1: PHASE events, e.g. search iterations, perft runs, analysed positions
+- 2: DETAIL events as well, e.g. every make_move and unmake_move
+Each thread records into its own ring buffer of BUFFER_SIZE events, which only
+it writes, so recording takes no locks; the oldest events are overwritten.
+Buffers are only read or cleared once recording threads have stopped.
+Timestamps are read from the TSC where there is one, and converted to
+microseconds when the buffers are dumped as Chrome trace-event JSON, which
+chrome://tracing and Perfetto load.
+
+  TRACE_SCOPE(PHASE, "iteration", depth); // Until the end of the scope
+  TRACE_EVENT(DETAIL, "cutoff", move);    // A single point in time
+
+Names must be string literals, and the argument is any integer.
+*/
+
+#ifndef TRACE_LEVEL
+  #define TRACE_LEVEL 0
+#endif
+
+namespace trace {
+
+enum { BUFFER_SIZE = 1 << 16 };
+
+struct event_t {
+  const char *name;
+  uint64_t start, end; // In ticks, equal for instant events
+  uint64_t arg;
+  uint32_t thread;
+};
+
+uint64_t now() noexcept;
+void record(const char *name, const uint64_t start, const uint64_t end, const uint64_t arg) noexcept;
+
+// Records an event lasting from construction to destruction
+class Scope {
+  const char *m_name;
+  uint64_t m_arg, m_start;
+
+public:
+  inline Scope(const char *name, const uint64_t arg) noexcept : m_name(name), m_arg(arg), m_start(now()) {}
+  inline ~Scope() noexcept { record(m_name, m_start, now(), m_arg); }
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+};
+
+// These read or reset every thread's buffer without a lock on the owner, so
+// they may only be called while no other thread is recording: before search
+// or analysis threads start, or after they are joined.
+// The number of events still in the buffers of every thread
+size_t num_events() noexcept;
+void clear() noexcept;
+void dump_chrome(std::ostream &out) noexcept;
+// Returns false if the file could not be written
+bool dump_chrome(const std::string &file_name) noexcept;
+
+} // namespace trace
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+#define TRACE_SCOPE(level, name, arg) TRACE_SCOPE_##level(name, arg)
+#define TRACE_EVENT(level, name, arg) TRACE_EVENT_##level(name, arg)
+#define TRACE_SCOPE_ENABLED(name, arg) \
+  const trace::Scope TRACE_CONCAT(trace_scope_, __LINE__)(name, (uint64_t)(arg))
+#define TRACE_EVENT_ENABLED(name, arg) \
+  do { const uint64_t trace_now = trace::now(); trace::record(name, trace_now, trace_now, (uint64_t)(arg)); } while (0)
+
+#if TRACE_LEVEL >= 1
+  #define TRACE_SCOPE_PHASE(name, arg) TRACE_SCOPE_ENABLED(name, arg)
+  #define TRACE_EVENT_PHASE(name, arg) TRACE_EVENT_ENABLED(name, arg)
+#else
+  #define TRACE_SCOPE_PHASE(name, arg) do {} while (0)
+  #define TRACE_EVENT_PHASE(name, arg) do {} while (0)
+#endif
+
+#if TRACE_LEVEL >= 2
+  #define TRACE_SCOPE_DETAIL(name, arg) TRACE_SCOPE_ENABLED(name, arg)
+  #define TRACE_EVENT_DETAIL(name, arg) TRACE_EVENT_ENABLED(name, arg)
+#else
+  #define TRACE_SCOPE_DETAIL(name, arg) do {} while (0)
+  #define TRACE_EVENT_DETAIL(name, arg) do {} while (0)
+#endif
+
+#endif /* end of include guard: TRACE_H */
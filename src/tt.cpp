@@ -0,0 +1,142 @@
+
+#include "tt.hpp"
+#include "move.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h> // for madvise
+#endif
+
+void tt_entry_t::save(const hash_t hash, const int score, const int eval,
+  const move_t move, const int depth, const Bound bound,
+  const uint8_t generation) noexcept {
+  ASSERT_MSG(-32768 <= score && score < 32768, "Score (%d) out of range", score);
+  ASSERT_MSG(-128 <= depth && depth < 128, "Depth (%d) out of range", depth);
+  ASSERT_MSG(bound != BOUND_NONE, "Saving entry without a bound");
+  const uint16_t key = hash & 0xFFFF;
+
+  // Keep the old move when we have none to replace it with
+  if (move != NULL_MOVE || key != key16)
+    move16 = move;
+
+  // Overwrite less valuable entries, but keep deeper results for this position
+  // unless the new result is exact or the old one is from a previous search
+  if (bound == BOUND_EXACT || key != key16 || depth + 4 > depth8
+    || relative_age(generation) != 0) {
+    key16 = key;
+    score16 = score;
+    eval16 = eval;
+    depth8 = depth;
+    gen_bound8 = generation | bound;
+  }
+}
+
+TranspositionTable::TranspositionTable(const size_t megabytes,
+  const bool use_huge_pages) noexcept {
+  resize(megabytes, use_huge_pages);
+}
+
+TranspositionTable::~TranspositionTable() noexcept {
+  free_table();
+}
+
+void TranspositionTable::free_table() noexcept {
+  std::free(m_table);
+  m_table = nullptr;
+  m_num_clusters = 0;
+  m_alloc_size = 0;
+  m_huge_pages = false;
+}
+
+void TranspositionTable::resize(const size_t megabytes,
+  const bool use_huge_pages) noexcept {
+  free_table();
+  m_num_clusters = std::max<size_t>(1, megabytes * 1024 * 1024 / sizeof(tt_cluster_t));
+  const size_t size = m_num_clusters * sizeof(tt_cluster_t);
+
+#if defined(__linux__)
+  // Transparent huge pages need a 2MB aligned region: most probes would
+  // otherwise miss in the TLB as well as in the cache
+  constexpr size_t huge_page_size = 2 * 1024 * 1024;
+  if (use_huge_pages && size >= huge_page_size) {
+    m_alloc_size = (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+    m_table = static_cast<tt_cluster_t *>(std::aligned_alloc(huge_page_size, m_alloc_size));
+    if (m_table != nullptr)
+      m_huge_pages = madvise(m_table, m_alloc_size, MADV_HUGEPAGE) == 0;
+  }
+#endif
+  if (m_table == nullptr) {
+    m_alloc_size = size;
+    m_table = static_cast<tt_cluster_t *>(std::aligned_alloc(alignof(tt_cluster_t), m_alloc_size));
+  }
+  ASSERT_MSG(m_table != nullptr, "Failed to allocate %zu MB for the TT", megabytes);
+  if (m_table == nullptr) {
+    ERROR("Failed to allocate transposition table");
+    std::exit(1);
+  }
+  clear();
+}
+
+void TranspositionTable::clear(const unsigned num_threads) noexcept {
+  // Zeroing a large table is bound by page faults and memory bandwidth, so
+  // split it into contiguous slices, one per thread
+  const unsigned threads = std::max(1u, num_threads);
+  const size_t stride = m_num_clusters / threads;
+  std::vector<std::thread> workers;
+  for (unsigned idx = 1; idx < threads; ++idx) {
+    workers.emplace_back([this, idx, stride, threads] {
+      const size_t start = stride * idx;
+      const size_t end = (idx + 1 == threads) ? m_num_clusters : start + stride;
+      std::memset(static_cast<void *>(&m_table[start]), 0, (end - start) * sizeof(tt_cluster_t));
+    });
+  }
+  const size_t end = (threads == 1) ? m_num_clusters : stride;
+  std::memset(static_cast<void *>(m_table), 0, end * sizeof(tt_cluster_t));
+  for (auto &worker : workers)
+    worker.join();
+  m_generation = 0;
+}
+
+tt_entry_t *TranspositionTable::probe(const hash_t hash, bool &found) const noexcept {
+  tt_entry_t *const entries = first_entry(hash);
+  const uint16_t key = hash & 0xFFFF;
+  for (unsigned idx = 0; idx < TT_CLUSTER_SIZE; ++idx) {
+    tt_entry_t &entry = entries[idx];
+    if (entry.empty()) {
+      found = false;
+      return &entry;
+    }
+    if (entry.key16 == key) {
+      // Refresh the generation so the entry survives the next replacement
+      entry.gen_bound8 = m_generation | entry.bound();
+      found = true;
+      return &entry;
+    }
+  }
+
+  // No match: pick the entry to be replaced, preferring shallow and old ones
+  tt_entry_t *replace = entries;
+  for (unsigned idx = 1; idx < TT_CLUSTER_SIZE; ++idx) {
+    const tt_entry_t &entry = entries[idx];
+    if (entry.depth() - 8 * entry.relative_age(m_generation)
+      < replace->depth() - 8 * replace->relative_age(m_generation))
+      replace = &entries[idx];
+  }
+  found = false;
+  return replace;
+}
+
+unsigned TranspositionTable::hashfull() const noexcept {
+  // Approximate occupancy in permille from a sample of the table
+  const size_t sample = std::min<size_t>(1000, m_num_clusters);
+  size_t count = 0;
+  for (size_t cluster = 0; cluster < sample; ++cluster)
+    for (const tt_entry_t &entry : m_table[cluster].entries)
+      count += !entry.empty() && entry.relative_age(m_generation) == 0;
+  return count * 1000 / (sample * TT_CLUSTER_SIZE);
+}
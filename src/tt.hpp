@@ -0,0 +1,111 @@
+
+#ifndef TT_H
+#define TT_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "defs.hpp"
+#include "assert.hpp"
+
+/*
+TT ENTRY:
+- move      - 16 bits
+- key       - 16 bits (low bits of the hash, the cluster index uses the high bits)
+- score     - 16 bits
+- eval      - 16 bits (static evaluation, saves re-evaluating on a hit)
+- depth     -  8 bits
+- gen/bound -  8 bits (generation in the upper 6 bits, bound in the lower 2)
+TOTAL: 10 bytes, 6 entries (+ 4 bytes padding) per 64 byte cluster
+*/
+
+enum Bound : uint8_t {
+  BOUND_NONE = 0, BOUND_UPPER = 1, BOUND_LOWER = 2, BOUND_EXACT = 3,
+};
+
+// NOTE: The generation counter lives above the bound bits, so it is bumped by
+// GENERATION_DELTA and wraps every 64 searches.
+enum { GENERATION_BITS = 2 };
+enum { GENERATION_DELTA = 1 << GENERATION_BITS };
+enum { GENERATION_MASK = (0xFF << GENERATION_BITS) & 0xFF };
+enum { GENERATION_CYCLE = 0xFF + GENERATION_DELTA };
+
+struct tt_entry_t {
+  move_t move16;
+  uint16_t key16;
+  int16_t score16;
+  int16_t eval16;
+  int8_t depth8;
+  uint8_t gen_bound8;
+
+  inline move_t move() const noexcept { return move16; }
+  inline int score() const noexcept { return score16; }
+  inline int eval() const noexcept { return eval16; }
+  inline int depth() const noexcept { return depth8; }
+  inline Bound bound() const noexcept { return (Bound)(gen_bound8 & (GENERATION_DELTA - 1)); }
+  inline bool empty() const noexcept { return bound() == BOUND_NONE; }
+
+  // Age of the entry in generations, relative to the given current generation
+  inline int relative_age(const uint8_t generation) const noexcept {
+    return ((GENERATION_CYCLE + generation - gen_bound8) & GENERATION_MASK) >> GENERATION_BITS;
+  }
+
+  void save(const hash_t hash, const int score, const int eval, const move_t move,
+    const int depth, const Bound bound, const uint8_t generation) noexcept;
+};
+
+enum { TT_CLUSTER_SIZE = 6 };
+
+struct alignas(64) tt_cluster_t {
+  tt_entry_t entries[TT_CLUSTER_SIZE];
+  char padding[64 - TT_CLUSTER_SIZE * sizeof(tt_entry_t)];
+};
+static_assert(sizeof(tt_entry_t) == 10, "Unexpected tt_entry_t size");
+static_assert(sizeof(tt_cluster_t) == 64, "Clusters must fill exactly one cache line");
+
+// A shared transposition table made of cache-line sized clusters. Concurrent
+// probes and stores from several search threads are deliberately unsynchronized:
+// a torn entry can at worst give a wrong score or a move which the search has
+// to validate before playing it anyway.
+class TranspositionTable {
+  tt_cluster_t *m_table = nullptr;
+  size_t m_num_clusters = 0;
+  size_t m_alloc_size = 0;
+  uint8_t m_generation = 0;
+  bool m_huge_pages = false;
+
+  void free_table() noexcept;
+
+public:
+  enum { DEFAULT_SIZE_MB = 16 };
+
+  TranspositionTable(const size_t megabytes = DEFAULT_SIZE_MB,
+    const bool use_huge_pages = true) noexcept;
+  ~TranspositionTable() noexcept;
+  TranspositionTable(const TranspositionTable &) = delete;
+  TranspositionTable &operator=(const TranspositionTable &) = delete;
+
+  void resize(const size_t megabytes, const bool use_huge_pages = true) noexcept;
+  void clear(const unsigned num_threads = 1) noexcept;
+  inline void new_search() noexcept { m_generation += GENERATION_DELTA; }
+  inline uint8_t generation() const noexcept { return m_generation; }
+  inline size_t num_clusters() const noexcept { return m_num_clusters; }
+  inline bool huge_pages() const noexcept { return m_huge_pages; }
+
+  inline tt_entry_t *first_entry(const hash_t hash) const noexcept {
+    ASSERT(m_table != nullptr);
+    // Map the hash onto [0, m_num_clusters) with a multiply-high instead of a
+    // modulus, so the table size need not be a power of two
+    __extension__ using uint128_t = unsigned __int128;
+    const size_t idx = ((uint128_t)hash * (uint128_t)m_num_clusters) >> 64;
+    return &m_table[idx].entries[0];
+  }
+  inline void prefetch(const hash_t hash) const noexcept {
+    __builtin_prefetch(first_entry(hash));
+  }
+
+  tt_entry_t *probe(const hash_t hash, bool &found) const noexcept;
+  unsigned hashfull() const noexcept;
+};
+
+#endif /* end of include guard: TT_H */
@@ -0,0 +1,275 @@
+
+#include "uci.hpp"
+#include "move.hpp"
+#include "nnue.hpp"
+#include "tb.hpp"
+
+#include <algorithm>
+#include <sstream>
+
+namespace uci {
+
+enum {
+  MAX_HASH_MB = 1 << 16,
+  MAX_THREADS = 256,
+};
+
+Engine::Engine(std::ostream &out) noexcept : m_out(out), m_searcher(m_tt) {
+  m_thread = std::thread([this] { search_loop(); });
+}
+
+Engine::~Engine() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_quit = true;
+    m_hold_result = false;
+  }
+  m_searcher.stop();
+  m_cv.notify_all();
+  m_thread.join();
+}
+
+void Engine::send(const std::string &line) noexcept {
+  std::lock_guard<std::mutex> lock(m_out_mutex);
+  m_out << line << std::endl;
+}
+
+void Engine::search_loop() noexcept {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    m_cv.wait(lock, [this] { return m_has_job || m_quit; });
+    if (m_quit)
+      return;
+    m_has_job = false;
+    const Board board = m_job_board;
+    const search_limits_t limits = m_job_limits;
+    // Once the job is taken, stop and ponderhit go straight to the searcher
+    m_searcher.arm(limits);
+    lock.unlock();
+
+    const search_info_t result = m_searcher.run(board, limits, [this](const search_info_t &info) {
+      send(info_line(info));
+    });
+
+    lock.lock();
+    m_cv.wait(lock, [this] { return !m_hold_result; });
+    std::string line = "bestmove " + (result.pv.empty() ? std::string("0000")
+      : uci_from_move(result.pv[0]));
+    if (result.pv.size() >= 2)
+      line += " ponder " + uci_from_move(result.pv[1]);
+    send(line);
+    m_searching = false;
+    m_cv.notify_all();
+  }
+}
+
+void Engine::wait() noexcept {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_cv.wait(lock, [this] { return !m_searching; });
+}
+
+void Engine::release_result() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_hold_result = false;
+  }
+  m_cv.notify_all();
+}
+
+std::string info_line(const search_info_t &info) noexcept {
+  std::ostringstream out;
+  out << "info depth " << info.depth << " seldepth " << info.seldepth << " score ";
+  if (is_mate_score(info.score)) {
+    out << "mate " << mate_moves(info.score);
+  } else {
+    out << "cp " << info.score;
+  }
+  const size_t time_ms = info.time_ns / 1000000;
+  out << " nodes " << info.nodes << " nps " << info.nodes * 1000000000 / std::max<size_t>(info.time_ns, 1)
+    << " time " << time_ms << " pv";
+  for (const move_t move : info.pv)
+    out << " " << uci_from_move(move);
+  return out.str();
+}
+
+void Engine::set_position(std::istream &args) noexcept {
+  std::string token, fen;
+  args >> token;
+  if (token == "startpos") {
+    fen = Board::startFEN;
+    args >> token;
+  } else if (token == "fen") {
+    while (args >> token && token != "moves")
+      fen += (fen.empty() ? "" : " ") + token;
+  } else {
+    return;
+  }
+  Board board(fen);
+  // Moves are matched against the legal moves in coordinate notation
+  while (token == "moves" && args >> token) {
+    const std::vector<move_t> moves = board.legal_moves();
+    const auto it = std::find_if(moves.begin(), moves.end(), [&](const move_t move) {
+      return uci_from_move(move) == token;
+    });
+    if (it == moves.end()) {
+      send("info string illegal move " + token);
+      break;
+    }
+    board.make_move(*it);
+    token = "moves";
+  }
+  m_board = board;
+}
+
+void Engine::go(std::istream &args) noexcept {
+  search_limits_t limits;
+  bool infinite = false;
+  size_t time_left[2] = {0, 0}, increment[2] = {0, 0};
+  size_t moves_to_go = 0;
+  std::string token;
+  while (args >> token) {
+    if (token == "depth")
+      args >> limits.depth;
+    else if (token == "nodes")
+      args >> limits.nodes;
+    else if (token == "movetime")
+      args >> limits.time_ms;
+    else if (token == "wtime")
+      args >> time_left[WHITE];
+    else if (token == "btime")
+      args >> time_left[BLACK];
+    else if (token == "winc")
+      args >> increment[WHITE];
+    else if (token == "binc")
+      args >> increment[BLACK];
+    else if (token == "movestogo")
+      args >> moves_to_go;
+    else if (token == "infinite")
+      infinite = true;
+    else if (token == "ponder")
+      limits.ponder = true;
+  }
+  limits.depth = std::clamp(limits.depth, 1, (int)MAX_PLY - 1);
+
+  const int side = m_board.m_next_move_colour;
+  limits.clock = {time_left[side], increment[side], moves_to_go};
+
+  wait();
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_job_board = m_board;
+    m_job_limits = limits;
+    m_hold_result = infinite || limits.ponder;
+    m_has_job = true;
+    m_searching = true;
+  }
+  m_cv.notify_all();
+}
+
+void Engine::set_option(std::istream &args) noexcept {
+  std::string token, name, value;
+  args >> token;
+  while (args >> token && token != "value")
+    name += (name.empty() ? "" : " ") + token;
+  while (args >> token)
+    value += (value.empty() ? "" : " ") + token;
+
+  wait();
+  std::istringstream number(value);
+  int amount = 0;
+  number >> amount;
+  if (name == "Hash") {
+    m_tt.resize(std::clamp(amount, 1, (int)MAX_HASH_MB));
+  } else if (name == "Threads") {
+    m_searcher.set_threads(std::clamp(amount, 1, (int)MAX_THREADS));
+  } else if (name == "EvalFile") {
+    if (!nnue::load(value))
+      send("info string could not load " + value);
+  } else if (name == "TablebasePath") {
+    tb::release();
+    if (value != "<empty>" && !value.empty())
+      send("info string loaded " + std::to_string(tb::init(value)) + " tablebases");
+  } else if (name == "Ponder") {
+    // Pondering is driven by the GUI, there is nothing to set up
+  } else if (!m_searcher.params().set(name, amount)) {
+    send("info string unknown option " + name);
+  }
+}
+
+bool Engine::handle(const std::string &line) noexcept {
+  std::istringstream args(line);
+  std::string command;
+  args >> command;
+  if (command == "uci") {
+    send("id name playchess");
+    send("id author nathanlo99");
+    send("option name Hash type spin default " + std::to_string(TranspositionTable::DEFAULT_SIZE_MB)
+      + " min 1 max " + std::to_string(MAX_HASH_MB));
+    send("option name Threads type spin default 1 min 1 max " + std::to_string(MAX_THREADS));
+    send("option name Ponder type check default false");
+    send("option name EvalFile type string default <empty>");
+    send("option name TablebasePath type string default <empty>");
+    for (const std::string &name : search_params_t::names()) {
+      int value = 0, min = 0, max = 0;
+      m_searcher.params().get(name, value);
+      search_params_t::range(name, min, max);
+      send("option name " + name + " type spin default " + std::to_string(value)
+        + " min " + std::to_string(min) + " max " + std::to_string(max));
+    }
+    send("uciok");
+  } else if (command == "isready") {
+    send("readyok");
+  } else if (command == "ucinewgame") {
+    wait();
+    m_tt.clear();
+    m_searcher.clear();
+  } else if (command == "position") {
+    wait();
+    set_position(args);
+  } else if (command == "go") {
+    go(args);
+  } else if (command == "stop") {
+    {
+      // A search that has not started yet would clear the stop
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_has_job)
+        m_job_limits.depth = 1;
+    }
+    m_searcher.stop();
+    release_result();
+  } else if (command == "ponderhit") {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (m_has_job)
+        m_job_limits.ponder = false;
+    }
+    m_searcher.ponderhit();
+    release_result();
+  } else if (command == "setoption") {
+    set_option(args);
+  } else if (command == "d") {
+    send(m_board.to_string() + "\n" + m_board.fen());
+  } else if (command == "quit") {
+    m_searcher.stop();
+    release_result();
+    return false;
+  } else if (!command.empty()) {
+    send("info string unknown command " + command);
+  }
+  return true;
+}
+
+int loop(std::istream &in, std::ostream &out) noexcept {
+  Engine engine(out);
+  std::thread input([&] {
+    std::string line;
+    while (std::getline(in, line) && engine.handle(line)) {}
+    // The end of the input ends the session, like quit
+    engine.handle("quit");
+    engine.wait();
+  });
+  input.join();
+  return 0;
+}
+
+} // namespace uci
@@ -0,0 +1,78 @@
+
+#ifndef UCI_H
+#define UCI_H
+
+#include <condition_variable>
+#include <istream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+#include "defs.hpp"
+#include "board.hpp"
+#include "search.hpp"
+#include "tt.hpp"
+
+/*
+UCI FRONT-END:
+Input is read and parsed on its own thread, and searches run on a persistent
+search thread, so stop and ponderhit take effect while a search is running.
+Infinite and ponder searches hold back their bestmove until stop or ponderhit,
+as the protocol requires. Output from both threads goes through one lock.
+*/
+
+namespace uci {
+
+class Engine {
+  std::ostream &m_out;
+  std::mutex m_out_mutex;
+
+  TranspositionTable m_tt;
+  Searcher m_searcher;
+  Board m_board;
+
+  // The search thread waits for a job, searches, then waits for the go-ahead
+  // to report when the search was infinite or pondering
+  std::thread m_thread;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  bool m_has_job = false, m_searching = false, m_hold_result = false, m_quit = false;
+  search_limits_t m_job_limits;
+  Board m_job_board;
+
+  void search_loop() noexcept;
+  void send(const std::string &line) noexcept;
+  void go(std::istream &args) noexcept;
+  void set_position(std::istream &args) noexcept;
+  void set_option(std::istream &args) noexcept;
+  // Lets a finished infinite or ponder search report its bestmove
+  void release_result() noexcept;
+
+public:
+  explicit Engine(std::ostream &out) noexcept;
+  ~Engine() noexcept;
+  Engine(const Engine &) = delete;
+  Engine &operator=(const Engine &) = delete;
+
+  // Handles one line of input, returning false on quit
+  bool handle(const std::string &line) noexcept;
+  // Blocks until no search is running
+  void wait() noexcept;
+  // Holds back output for as long as the lock is held, so that the stream
+  // given to the constructor can be read while a search is running
+  inline std::unique_lock<std::mutex> lock_output() noexcept {
+    return std::unique_lock<std::mutex>(m_out_mutex);
+  }
+  inline const Board &position() const noexcept { return m_board; }
+};
+
+// "info ..." for a completed iteration
+std::string info_line(const search_info_t &info) noexcept;
+
+// Speaks UCI on in and out until quit or the end of the input
+int loop(std::istream &in, std::ostream &out) noexcept;
+
+} // namespace uci
+
+#endif /* end of include guard: UCI_H */
@@ -3,12 +3,50 @@
 #include "test_squares.hpp"
 #include "test_board.hpp"
 #include "test_perft.hpp"
+#include "test_tt.hpp"
+#include "test_search.hpp"
+#include "test_timeman.hpp"
+#include "test_analysis.hpp"
+#include "test_stats.hpp"
+#include "test_trace.hpp"
+#include "test_hwperf.hpp"
+#include "test_bench.hpp"
+#include "test_eval.hpp"
+#include "test_pawns.hpp"
+#include "test_material.hpp"
+#include "test_nnue.hpp"
+#include "test_tactical.hpp"
+#include "test_see.hpp"
+#include "test_move_order.hpp"
+#include "test_mcts.hpp"
+#include "test_mate.hpp"
+#include "test_tb.hpp"
+#include "test_uci.hpp"
 
 int run_tests(const std::string &fen, const int perft_depth) {
   int fail_flag = 0;
   fail_flag |= test_pieces();
   fail_flag |= test_squares();
   fail_flag |= test_board();
+  fail_flag |= test_tt();
+  fail_flag |= test_eval();
+  fail_flag |= test_pawns();
+  fail_flag |= test_material();
+  fail_flag |= test_nnue();
+  fail_flag |= test_tactical();
+  fail_flag |= test_see();
+  fail_flag |= test_move_order();
+  fail_flag |= test_search();
+  fail_flag |= test_timeman();
+  fail_flag |= test_analysis();
+  fail_flag |= test_stats();
+  fail_flag |= test_trace();
+  fail_flag |= test_hwperf();
+  fail_flag |= test_bench();
+  fail_flag |= test_mcts();
+  fail_flag |= test_mate();
+  fail_flag |= test_tb();
+  fail_flag |= test_uci();
   fail_flag |= test_perft(fen, perft_depth);
   return fail_flag;
 }
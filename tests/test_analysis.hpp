@@ -0,0 +1,83 @@
+
+#ifndef TEST_ANALYSIS_H
+#define TEST_ANALYSIS_H
+
+#include <sstream>
+#include <string>
+
+#include "analysis.hpp"
+#include "assert.hpp"
+#include "board.hpp"
+
+inline int test_analysis() {
+  int fail_flag = 0;
+
+  { /* Positions are found in EPD, FEN and perft lines */
+    ASSERT(fen_from_epd("4k3/8/8/8/8/8/8/4K2R w K - bm O-O; id \"castle\";") == "4k3/8/8/8/8/8/8/4K2R w K - 0 1");
+    ASSERT(fen_from_epd(std::string(Board::startFEN) + "; 20; 400") == Board::startFEN);
+    ASSERT(fen_from_epd("4k3/8/8/8/8/8/8/4K3 b - - 3 40") == "4k3/8/8/8/8/8/8/4K3 b - - 3 40");
+    ASSERT(fen_from_epd("not a position").empty());
+    ASSERT(fen_from_epd("4k3/8/8/8/8/8/8/4K3 x - -").empty());
+    ASSERT(fen_from_epd("4k3/8/8/8/8/8/8/8 w - -").empty());
+    ASSERT(fen_from_epd("4k3/9/8/8/8/8/8/4K3 w - -").empty());
+  }
+
+  { /* Positions Board can't play from are rejected with the reason */
+    std::string error;
+    ASSERT(fen_from_epd("P3k3/8/8/8/8/8/8/4K3 w - -", error).empty() && error == "pawn on back rank");
+    ASSERT(fen_from_epd("4k3/8/8/8/8/8/8/p3K3 b - -", error).empty() && error == "pawn on back rank");
+    ASSERT(fen_from_epd("4k3/8/8/8/4P3/8/8/4K3 w - e3", error).empty());
+    ASSERT(error == "en passant square without a pawn to capture");
+    ASSERT(fen_from_epd("4k3/8/8/8/8/8/8/4K3 w - e6", error).empty());
+    ASSERT(error == "en passant square without a pawn to capture");
+    ASSERT(fen_from_epd("R3K3/8/8/8/8/8/8/4k3 w k -", error).empty());
+    ASSERT(error == "castling rights without king and rook");
+    ASSERT(fen_from_epd("4k3/8/8/8/8/8/8/R3K3 w KQ -", error).empty());
+    ASSERT(error == "castling rights without king and rook");
+    ASSERT(fen_from_epd("4k3/8/8/8/8/8/8/4K2R w - -", error) == "4k3/8/8/8/8/8/8/4K2R w - - 0 1");
+    ASSERT(error.empty());
+    ASSERT(fen_from_epd("4k3/8/8/8/8/8/8/4R1K1 w - -", error).empty() && error == "side not to move in check");
+    ASSERT(fen_from_epd("4k3/8/8/8/8/8/8/4K1r1 b - -", error).empty() && error == "side not to move in check");
+    ASSERT(fen_from_epd("4k3/3P4/8/8/8/8/8/4K3 w - -", error).empty() && error == "side not to move in check");
+    ASSERT(fen_from_epd("4k3/8/3N4/8/8/8/8/4K3 w - -", error).empty() && error == "side not to move in check");
+    ASSERT(fen_from_epd("4k3/8/8/8/B7/8/8/4K3 w - -", error).empty() && error == "side not to move in check");
+    ASSERT(fen_from_epd("4k3/8/8/8/B7/8/8/4K3 b - -", error) == "4k3/8/8/8/B7/8/8/4K3 b - - 0 1");
+    ASSERT(fen_from_epd("4k3/8/8/3pP3/8/8/8/4K3 w - d6", error) == "4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1");
+    ASSERT(fen_from_epd("4k3/8/8/8/3pP3/8/8/4K3 b - e3", error) == "4k3/8/8/8/3pP3/8/8/4K3 b - e3 0 1");
+  }
+
+  { /* Results stream out in input order, one JSON line each */
+    std::istringstream in(
+      "6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1\n"
+      "# a comment\n"
+      "garbage\n"
+      + std::string(Board::startFEN) + "; 20; 400\n"
+      "\n"
+      "7k/8/5K2/8/8/8/8/R7 w - - bm Kg6;\n"
+      "R3K3/8/8/8/8/8/8/4k3 w k -\n"
+      "4k3/8/8/8/8/8/8/4R1K1 w - -\n");
+    std::ostringstream out;
+    analysis_options_t options;
+    options.limits.depth = 3;
+    options.limits.multi_pv = 2;
+    options.threads = 2;
+    options.hash_mb = 1;
+    ASSERT(analyse_epd(in, out, options) == 3);
+
+    std::istringstream lines(out.str());
+    std::string line;
+    const char *const expected_starts[] = {"{\"line\":1,", "{\"line\":3,\"error\"",
+      "{\"line\":4,", "{\"line\":6,",
+      "{\"line\":7,\"error\":\"castling rights without king and rook\"}",
+      "{\"line\":8,\"error\":\"side not to move in check\"}"};
+    for (const char *const start : expected_starts) {
+      std::getline(lines, line);
+      ASSERT_MSG(line.rfind(start, 0) == 0, "Unexpected output %s", line.c_str());
+    }
+    ASSERT(!std::getline(lines, line));
+    ASSERT(out.str().find("\"lines\":[{\"mate\":1,\"pv\":[\"a1a8\"]},{\"cp\":") != std::string::npos);
+  }
+  return fail_flag;
+}
+
+#endif /* end of include guard: TEST_ANALYSIS_H */
@@ -0,0 +1,41 @@
+
+#ifndef TEST_BENCH_H
+#define TEST_BENCH_H
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "assert.hpp"
+#include "bench.hpp"
+#include "board.hpp"
+
+inline int test_bench() {
+  int fail_flag = 0;
+  // One preempted sample is dropped, and does not move the statistics
+  const bench::summary_t summary = bench::summarise("test", 10, {10, 11, 10, 9, 10, 500});
+  ASSERT(summary.samples == 6 && summary.kept == 5);
+  ASSERT(summary.median_ns == 10 && summary.min_ns == 9 && summary.mean_ns == 10);
+  ASSERT(summary.stddev_ns > 0 && summary.stddev_ns < 1);
+
+  // The same positions for the same seed
+  const std::vector<std::string> corpus = bench::sample_corpus(2, 7, 40, 4);
+  ASSERT(!corpus.empty() && corpus.size() <= 20);
+  ASSERT(Board(corpus[0]).hash() == Board().hash());
+  ASSERT(corpus == bench::sample_corpus(2, 7, 40, 4));
+  // Every position parses back without losing its en passant square
+  for (const std::string &fen : corpus)
+    ASSERT(Board(fen).fen() == fen);
+
+  const std::vector<bench::summary_t> results = bench::run(corpus, 3);
+  ASSERT(results.size() == 14);
+  ASSERT(results[0].name == "fen parse" && results[0].samples == 3);
+  for (const bench::summary_t &result : results)
+    ASSERT_IF(result.samples > 0, result.kept > 0 && result.median_ns > 0);
+  std::ostringstream out;
+  bench::report(out, results);
+  ASSERT(out.str().find("make+unmake quiet") != std::string::npos);
+  return fail_flag;
+}
+
+#endif /* end of include guard: TEST_BENCH_H */
@@ -2,8 +2,10 @@
 #ifndef TEST_BOARD_H
 #define TEST_BOARD_H
 
+#include <algorithm>
 #include <string>
 #include <iostream>
+#include <vector>
 
 #include "assert.hpp"
 #include "board.hpp"
@@ -34,6 +36,7 @@ const static std::string testFENs[] = {
   "3Q4/1Q4Q1/4Q3/2Q4R/Q4Q2/3Q4/1Q4Rp/1K1BBNNk w - - 0 1",
   "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
   "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+  "rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 3",
 };
 
 inline int test_board() {
@@ -41,6 +44,83 @@ inline int test_board() {
   for (const auto &fen : testFENs) {
     fail_flag |= test_fen(fen);
   }
+
+  { /* Repetitions, within the moves since the last capture or pawn move */
+    Board board;
+    const auto shuffle = [&board]() {
+      board.make_move(quiet_move(G1, F3));
+      board.make_move(quiet_move(G8, F6));
+      board.make_move(quiet_move(F3, G1));
+      board.make_move(quiet_move(F6, G8));
+    };
+    ASSERT(!board.is_repetition(1));
+    shuffle();
+    ASSERT(board.is_repetition(1) && !board.is_repetition(2) && !board.is_drawn());
+    shuffle();
+    ASSERT(board.is_repetition(2) && board.is_drawn());
+    board.unmake_move();
+    ASSERT(board.is_repetition(1) && !board.is_drawn());
+    board.make_move(quiet_move(F6, G8));
+    // Only the moves since the last pawn move are scanned
+    board.make_move(quiet_move(E2, E3));
+    ASSERT(!board.is_repetition(1));
+    board.make_move(quiet_move(G8, F6));
+    board.make_move(quiet_move(G1, F3));
+    board.make_move(quiet_move(F6, G8));
+    board.make_move(quiet_move(F3, G1));
+    ASSERT(board.is_repetition(1) && !board.is_repetition(2));
+  }
+
+  { /* Null moves only pass the turn, and clear en passant */
+    Board board("rnbqkbnr/ppp1pppp/8/8/3p4/8/PPPPPPPP/RNBQKBNR w KQkq - 0 3");
+    board.make_move(double_move(E2, E4));
+    const hash_t start = board.hash();
+    board.make_null_move();
+    ASSERT(board.hash() == Board("rnbqkbnr/ppp1pppp/8/8/3pP3/8/PPPP1PPP/RNBQKBNR w KQkq - 0 4").hash());
+    ASSERT(board.m_history.back().move == NULL_MOVE && !board.is_repetition(1));
+    board.unmake_null_move();
+    ASSERT(board.hash() == start && board.m_en_passant == E3 && board.m_history.size() == 1);
+  }
+
+  { /* Zobrist keys are fixed at compile time, so hashes match across builds */
+    static_assert(enpas_hash(INVALID_SQUARE) == 0 && side_hash != 0);
+    ASSERT(Board().hash() == 0x8CBBFFF8AFA9478AULL);
+  }
+
+  { /* Moves only hold squares and a flag, make_move reads the pieces off the board */
+    static_assert(sizeof(move_t) == 2);
+    const move_t move = promote_capture_move(B7, A8, WHITE_QUEEN);
+    ASSERT(move_from(move) == B7 && move_to(move) == A8 && move_flag(move) == PROMOTE_QUEEN_CAPTURE_MOVE);
+    ASSERT(promoted_piece(move) == WHITE_QUEEN);
+    ASSERT(promoted_piece(promote_move(B2, B1, WHITE_KNIGHT)) == BLACK_KNIGHT);
+    Board board("r3k3/1P6/8/8/8/8/8/4K3 w q - 0 1");
+    const bool legal = board.make_move(move);
+    ASSERT(legal);
+    ASSERT(board.m_history.back().moved == WHITE_PAWN && board.m_history.back().captured == BLACK_ROOK);
+    ASSERT(!board.can_castle(BLACK_LONG));
+    board.unmake_move();
+    ASSERT(board.piece_at(A8) == BLACK_ROOK && board.piece_at(B7) == WHITE_PAWN);
+  }
+
+  { /* Every quiet move and pawn push is among the unmoves of its result */
+    for (const std::string &fen : {testFENs[9], testFENs[10], testFENs[5]}) {
+      Board board(fen);
+      for (const move_t move : board.legal_moves()) {
+        const MoveFlag flag = move_flag(move);
+        if (flag != QUIET_MOVE && flag != DOUBLE_PAWN_MOVE)
+          continue;
+        board.make_move(move);
+        const std::vector<move_t> unmoves = board.unmoves();
+        ASSERT(std::find(unmoves.begin(), unmoves.end(), move) != unmoves.end());
+        board.unmake_move();
+      }
+    }
+    // A pawn on its starting rank has no unmoves
+    const std::vector<move_t> unmoves = Board("4k3/8/8/8/8/8/P7/4K3 b - - 0 1").unmoves();
+    ASSERT(std::find_if(unmoves.begin(), unmoves.end(), [](const move_t move) {
+      return move_to(move) == A2;
+    }) == unmoves.end());
+  }
   return fail_flag;
 }
 
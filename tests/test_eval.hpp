@@ -0,0 +1,45 @@
+
+#ifndef TEST_EVAL_H
+#define TEST_EVAL_H
+
+#include <string>
+
+#include "assert.hpp"
+#include "board.hpp"
+#include "eval.hpp"
+#include "move.hpp"
+
+inline int test_eval() {
+  int fail_flag = 0;
+  { /* Symmetric positions are level */
+    const Board board;
+    ASSERT(board.m_phase == MAX_PHASE);
+    ASSERT(board.m_psq.mg == 0 && board.m_psq.eg == 0);
+    ASSERT(evaluate(board) == 0);
+  }
+
+  { /* Colour-flipped positions score the same for the side to move */
+    const Board white("r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4");
+    const Board black("rnbqk2r/pppp1ppp/5n2/2b1p3/4P3/2N2N2/PPPP1PPP/R1BQKB1R b KQkq - 4 4");
+    ASSERT(evaluate(white) == evaluate(black));
+  }
+
+  { /* Incremental sums are restored by unmake_move */
+    Board board("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    const psq_t psq = board.m_psq;
+    const int phase = board.m_phase;
+    for (const move_t move : board.generate_moves()) {
+      if (board.make_move(move)) {
+        ASSERT(board.m_psq == board.compute_psq());
+        ASSERT(board.m_phase == board.compute_phase());
+      }
+      board.unmake_move();
+      if (!(board.m_psq == psq && board.m_phase == phase))
+        fail_flag = 1;
+    }
+    ASSERT_MSG(fail_flag == 0, "Piece-square sums not restored by unmake_move");
+  }
+  return fail_flag;
+}
+
+#endif /* end of include guard: TEST_EVAL_H */
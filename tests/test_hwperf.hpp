@@ -0,0 +1,30 @@
+
+#ifndef TEST_HWPERF_H
+#define TEST_HWPERF_H
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "assert.hpp"
+#include "board.hpp"
+#include "hwperf.hpp"
+
+inline int test_hwperf() {
+  int fail_flag = 0;
+  // Counters may be unavailable here, wall time is always measured
+  const std::vector<hwperf::result_t> results = hwperf::run({Board::startFEN}, 2, 2);
+  ASSERT(results.size() == 7);
+  ASSERT(results[0].name == "make_move" && results[0].operations > 0);
+  ASSERT(results.back().operations == 2 * 400);
+  for (const hwperf::result_t &result : results) {
+    fail_flag |= result.sample.ns == 0;
+    ASSERT_IF(result.sample.valid[hwperf::INSTRUCTIONS], result.sample.counts[hwperf::INSTRUCTIONS] > 0);
+  }
+  std::ostringstream out;
+  hwperf::report(out, results);
+  ASSERT(out.str().find("perft 2 (per leaf)") != std::string::npos);
+  return fail_flag;
+}
+
+#endif /* end of include guard: TEST_HWPERF_H */
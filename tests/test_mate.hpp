@@ -0,0 +1,79 @@
+
+#ifndef TEST_MATE_H
+#define TEST_MATE_H
+
+#include <string>
+#include <vector>
+
+#include "assert.hpp"
+#include "board.hpp"
+#include "mate.hpp"
+#include "move.hpp"
+
+// Whether line is legal from fen and ends in checkmate
+inline bool ends_in_mate(const std::string &fen, const std::vector<move_t> &line) {
+  Board board(fen);
+  for (const move_t move : line) {
+    if (!board.make_move(move))
+      return false;
+  }
+  return board.king_in_check() && board.legal_moves().empty();
+}
+
+inline int test_mate() {
+  { /* Back-rank mate in one */
+    const std::string fen = "6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1";
+    const mate_result_t result = MateSolver().solve(fen);
+    ASSERT(result.status == MATE_PROVEN);
+    ASSERT(result.pv.size() == 1 && result.pv[0] == quiet_move(A1, A8));
+  }
+
+  { /* Longer mates, for either side, give a line ending in mate */
+    for (const std::string fen : {"7k/8/5K2/8/8/8/8/R7 w - - 0 1",
+        "r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 0 1",
+        "k7/8/8/8/1r6/r7/8/7K b - - 0 1"}) {
+      const mate_result_t result = MateSolver().solve(fen);
+      ASSERT(result.status == MATE_PROVEN && result.pv.size() % 2 == 1);
+      ASSERT(ends_in_mate(fen, result.pv));
+    }
+    // Within three plies, which needs the quiet Kg6 first
+    mate_limits_t limits;
+    limits.max_plies = 3;
+    const std::string fen = "7k/8/5K2/8/8/8/8/R7 w - - 0 1";
+    const mate_result_t result = MateSolver(limits).solve(fen);
+    ASSERT(result.status == MATE_PROVEN && result.pv.size() == 3);
+    ASSERT(result.pv[0] == quiet_move(F6, G6));
+    limits.checks_only = true;
+    ASSERT(MateSolver(limits).solve(fen).status == MATE_DISPROVEN);
+  }
+
+  { /* Positions reached by transposition at another ply only reuse results
+       that hold for the plies left there */
+    const std::string fen = "8/4K3/8/3k4/6R1/8/q1Q5/8 w - - 0 1";
+    mate_limits_t limits;
+    limits.max_plies = 7;
+    const mate_result_t result = MateSolver(limits).solve(fen);
+    ASSERT(result.status == MATE_PROVEN && result.pv.size() <= 7);
+    ASSERT(ends_in_mate(fen, result.pv));
+  }
+
+  { /* Disproofs */
+    // No mating material
+    ASSERT(MateSolver().solve("4k3/8/8/8/8/8/8/4KB2 w - - 0 1").status == MATE_DISPROVEN);
+    // Rook mates take longer than three plies from the centre
+    mate_limits_t limits;
+    limits.max_plies = 3;
+    const mate_result_t result = MateSolver(limits).solve("8/8/8/4k3/8/8/8/R3K3 w - - 0 1");
+    ASSERT(result.status == MATE_DISPROVEN);
+  }
+
+  { /* The node budget is respected */
+    mate_limits_t limits;
+    limits.nodes = 100;
+    const mate_result_t result = MateSolver(limits).solve("8/8/8/4k3/8/8/8/R3K3 w - - 0 1");
+    ASSERT(result.status == MATE_UNKNOWN && result.nodes <= 100);
+  }
+  return 0;
+}
+
+#endif /* end of include guard: TEST_MATE_H */
@@ -0,0 +1,67 @@
+
+#ifndef TEST_MATERIAL_H
+#define TEST_MATERIAL_H
+
+#include <string>
+
+#include "assert.hpp"
+#include "board.hpp"
+#include "endgame.hpp"
+#include "eval.hpp"
+#include "material.hpp"
+#include "move.hpp"
+
+inline int test_material() {
+  { /* The key follows captures and promotions, and is restored by unmake */
+    Board board("1r2k3/P7/8/8/8/8/8/4K3 w - - 0 1");
+    const uint32_t start = board.m_material_key;
+    ASSERT(start == compute_material_key(board.m_num_pieces));
+    board.make_move(promote_capture_move(A7, B8, WHITE_QUEEN));
+    ASSERT(board.m_material_key == Board(board.fen()).m_material_key);
+    ASSERT(board.m_material_key != start);
+    board.unmake_move();
+    ASSERT(board.m_material_key == start);
+  }
+
+  { /* Insufficient material */
+    ASSERT(Board("4k3/8/8/8/8/8/8/4K3 w - - 0 1").is_drawn());
+    ASSERT(Board("4k3/8/8/8/8/8/8/4KN2 w - - 0 1").is_drawn());
+    ASSERT(Board("4kb2/8/8/8/8/8/8/4K3 b - - 0 1").is_drawn());
+    ASSERT(!Board("4k3/8/8/8/8/8/8/R3K3 w - - 0 1").is_drawn());
+    ASSERT(!Board("4k3/8/8/8/8/8/4P3/4K3 w - - 0 1").is_drawn());
+    // Two knights cannot force mate, but the position is not dead
+    const Board knights("4k3/8/8/8/8/8/8/4KNN1 w - - 0 1");
+    ASSERT(!knights.is_drawn() && evaluate(knights) == 0);
+  }
+
+  { /* KPK bitbase */
+    // King on the sixth in front of its pawn wins with either side to move
+    ASSERT(evaluate(Board("4k3/8/4K3/4P3/8/8/8/8 w - - 0 1")) > KNOWN_WIN);
+    ASSERT(evaluate(Board("4k3/8/4K3/4P3/8/8/8/8 b - - 0 1")) < -KNOWN_WIN);
+    ASSERT(evaluate(Board("8/8/8/8/4p3/4k3/8/4K3 w - - 0 1")) < -KNOWN_WIN);
+    // The defending king holds the opposition, and the rook pawn is a draw
+    ASSERT(evaluate(Board("8/8/8/8/8/4k3/4P3/4K3 w - - 0 1")) == 0);
+    ASSERT(evaluate(Board("k7/8/K7/P7/8/8/8/8 w - - 0 1")) == 0);
+  }
+
+  { /* Mating patterns */
+    // KBNK mates in the corner of the bishop's colour (c1 is dark)
+    ASSERT(evaluate(Board("7k/8/8/8/8/8/8/2B1KN2 w - - 0 1"))
+      > evaluate(Board("k7/8/8/8/8/8/8/2B1KN2 w - - 0 1")));
+    // KXK drives the bare king to the edge
+    ASSERT(evaluate(Board("8/8/8/8/8/8/8/k1K4R w - - 0 1"))
+      > evaluate(Board("8/8/8/3k4/8/8/8/2K4R w - - 0 1")));
+    ASSERT(evaluate(Board("8/8/8/3k4/8/8/8/2K4R b - - 0 1")) < -KNOWN_WIN);
+  }
+
+  { /* Boards beyond the table are computed on the side */
+    const Board board("4k3/8/8/8/8/8/8/QQK5 w - - 0 1");
+    ASSERT(!material_in_table(board.m_num_pieces));
+    material_entry_t scratch;
+    ASSERT(&probe_material(board, scratch) == &scratch);
+    ASSERT(scratch.endgame == KXK_ENDGAME && scratch.strong_side == WHITE);
+  }
+  return 0;
+}
+
+#endif /* end of include guard: TEST_MATERIAL_H */
@@ -0,0 +1,57 @@
+
+#ifndef TEST_MCTS_H
+#define TEST_MCTS_H
+
+#include <string>
+#include <vector>
+
+#include "assert.hpp"
+#include "board.hpp"
+#include "move.hpp"
+#include "strategies/mcts_strat.hpp"
+
+inline int test_mcts() {
+  { /* Mate in one is found, with one thread and tree-parallel */
+    const Board board("6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1");
+    const std::vector<move_t> moves = board.legal_moves();
+    for (const unsigned threads : {1u, 2u}) {
+      MCTSStrategy mcts(200, threads, 1 << 16);
+      mcts.init(board);
+      ASSERT(moves[mcts.choose(board, moves)] == quiet_move(A1, A8));
+      ASSERT(mcts.nodes_used() <= (1 << 16));
+    }
+  }
+
+  { /* The subtree under the chosen move and the reply is kept */
+    Board board;
+    MCTSStrategy mcts(150, 1, 1 << 16);
+    mcts.init(board);
+    std::vector<move_t> moves = board.legal_moves();
+    board.make_move(moves[mcts.choose(board, moves)]);
+    ASSERT(mcts.root_visits() > 0);
+    // The reply searched most from the first root
+    moves = board.legal_moves();
+    move_t reply = moves[0];
+    uint32_t reply_visits = 0;
+    for (const move_t move : moves) {
+      if (mcts.child_visits(move) > reply_visits) {
+        reply = move;
+        reply_visits = mcts.child_visits(move);
+      }
+    }
+    ASSERT(reply_visits > 0);
+    board.make_move(reply);
+    moves = board.legal_moves();
+    board.make_move(moves[mcts.choose(board, moves)]);
+    ASSERT(mcts.reused_visits() >= reply_visits);
+    // Tiny arenas compact or restart instead of overflowing
+    MCTSStrategy small(150, 2, 256);
+    small.init(board);
+    moves = board.legal_moves();
+    board.make_move(moves[small.choose(board, moves)]);
+    ASSERT(small.nodes_used() <= 256);
+  }
+  return 0;
+}
+
+#endif /* end of include guard: TEST_MCTS_H */
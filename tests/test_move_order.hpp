@@ -0,0 +1,62 @@
+
+#ifndef TEST_MOVE_ORDER_H
+#define TEST_MOVE_ORDER_H
+
+#include <algorithm>
+#include <vector>
+
+#include "assert.hpp"
+#include "board.hpp"
+#include "move.hpp"
+#include "move_order.hpp"
+
+inline int move_score(const std::vector<move_t> &moves,
+  const std::vector<int> &scores, const move_t move) {
+  const auto &it = std::find(moves.begin(), moves.end(), move);
+  ASSERT_MSG(it != moves.end(), "Move %s not generated", string_from_move(move).c_str());
+  return scores[it - moves.begin()];
+}
+
+inline int test_move_order() {
+  const Board board("4k3/8/8/3q4/4P3/8/8/3QK1N1 w - - 0 1");
+  const std::vector<move_t> moves = board.generate_moves();
+  const move_t pawn_takes = capture_move(E4, D5);
+  const move_t queen_takes = capture_move(D1, D5);
+  const move_t knight_move = quiet_move(G1, F3);
+  const move_t queen_move = quiet_move(D1, D2);
+  const move_t pawn_move = quiet_move(E4, E5);
+  MoveOrder ordering;
+  std::vector<int> scores;
+
+  { /* MVV-LVA, with the TT move ahead of everything */
+    ordering.score_moves(board, moves, scores, queen_move, 0);
+    ASSERT(move_score(moves, scores, queen_move) == TT_MOVE_SCORE);
+    ASSERT(move_score(moves, scores, pawn_takes) > move_score(moves, scores, queen_takes));
+    ASSERT(move_score(moves, scores, queen_takes) > move_score(moves, scores, knight_move));
+  }
+
+  { /* Killers and history after a cutoff */
+    ordering.update_quiet_stats(board, knight_move, {pawn_move, knight_move}, 4, 3);
+    ordering.score_moves(board, moves, scores, NULL_MOVE, 3);
+    ASSERT(ordering.is_killer(knight_move, 3));
+    ASSERT(move_score(moves, scores, knight_move) == KILLER_SCORE + 1);
+    ASSERT(move_score(moves, scores, pawn_takes) > move_score(moves, scores, knight_move));
+    ASSERT(ordering.history(board, knight_move) > 0);
+    ASSERT(ordering.history(board, pawn_move) < 0);
+    ordering.score_moves(board, moves, scores, NULL_MOVE, 2);
+    ASSERT(move_score(moves, scores, knight_move) == ordering.history(board, knight_move));
+  }
+
+  { /* pick_move yields moves by descending score */
+    ordering.score_moves(board, moves, scores, NULL_MOVE, 0);
+    std::vector<move_t> picked = moves;
+    std::vector<int> picked_scores = scores;
+    for (size_t idx = 0; idx < picked.size(); ++idx)
+      pick_move(picked, picked_scores, idx);
+    ASSERT(picked[0] == pawn_takes);
+    ASSERT(std::is_sorted(picked_scores.rbegin(), picked_scores.rend()));
+  }
+  return 0;
+}
+
+#endif /* end of include guard: TEST_MOVE_ORDER_H */
@@ -0,0 +1,92 @@
+
+#ifndef TEST_NNUE_H
+#define TEST_NNUE_H
+
+#include <cstdio>
+#include <filesystem>
+#include <random>
+#include <string>
+
+#include "assert.hpp"
+#include "board.hpp"
+#include "eval.hpp"
+#include "move.hpp"
+#include "nnue.hpp"
+
+// A network with small random weights, so that nothing saturates
+inline void random_network(nnue::network_t &net, const unsigned seed) {
+  std::mt19937 gen(seed);
+  const auto &random = [&](const int lo, const int hi) {
+    return std::uniform_int_distribution<int>(lo, hi)(gen);
+  };
+  for (auto &value : net.ft_bias) value = random(0, 32);
+  for (auto &value : net.ft_weights) value = random(-8, 8);
+  for (auto &value : net.l2_bias) value = random(-512, 512);
+  for (auto &value : net.l2_weights) value = random(-32, 32);
+  for (auto &value : net.l3_bias) value = random(-512, 512);
+  for (auto &value : net.l3_weights) value = random(-64, 64);
+  net.out_bias = random(-1024, 1024);
+  for (auto &value : net.out_weights) value = random(-127, 127);
+}
+
+// Accumulators match a refresh and the SIMD path matches the scalar one
+// everywhere in the tree below board
+inline int test_nnue_tree(Board &board, const int depth) {
+  nnue::accumulator_t fresh;
+  nnue::refresh(fresh, board, WHITE);
+  nnue::refresh(fresh, board, BLACK);
+  ASSERT_MSG(fresh.values == board.m_accumulator.values, "Stale accumulator in %s", board.fen().c_str());
+  ASSERT(nnue::evaluate(board) == nnue::evaluate_scalar(board));
+  if (depth == 0)
+    return 0;
+  for (const move_t move : board.generate_moves()) {
+    if (board.make_move(move))
+      test_nnue_tree(board, depth - 1);
+    board.unmake_move();
+  }
+  return 0;
+}
+
+inline int test_nnue() {
+  const std::string path = (std::filesystem::temp_directory_path() / "playchess_test.nnue").string();
+  ASSERT(!nnue::load(path + ".missing"));
+  ASSERT(!nnue::enabled());
+
+  Board early;
+  auto net = std::make_unique<nnue::network_t>();
+  random_network(*net, 1234);
+  // Not inside ASSERT, which release builds compile out
+  const bool saved = nnue::save(*net, path), loaded = nnue::load(path);
+  ASSERT(saved && loaded && nnue::enabled());
+  if (!loaded)
+    return 1;
+
+  { /* A board from before the network was loaded catches up on refresh */
+    early.refresh_accumulator();
+    const Board board;
+    ASSERT(early.m_accumulator.values == board.m_accumulator.values);
+    ASSERT(evaluate(board) == nnue::evaluate(board));
+  }
+
+  for (const std::string fen : {
+    Board::startFEN,
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2P5/8/8/8/8/3p2k1/K7 b - - 0 1",
+  }) {
+    Board board(fen);
+    test_nnue_tree(board, 2);
+  }
+
+  { /* Both perspectives share the weights, so mirrored positions agree */
+    const Board white("r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4");
+    const Board black("rnbqk2r/pppp1ppp/5n2/2b1p3/4P3/2N2N2/PPPP1PPP/R1BQKB1R b KQkq - 4 4");
+    ASSERT(evaluate(white) == evaluate(black));
+  }
+
+  nnue::unload();
+  std::remove(path.c_str());
+  ASSERT(!nnue::enabled());
+  return 0;
+}
+
+#endif /* end of include guard: TEST_NNUE_H */
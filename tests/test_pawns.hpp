@@ -0,0 +1,64 @@
+
+#ifndef TEST_PAWNS_H
+#define TEST_PAWNS_H
+
+#include <string>
+
+#include "assert.hpp"
+#include "board.hpp"
+#include "eval.hpp"
+#include "move.hpp"
+#include "pawns.hpp"
+
+inline pawn_entry_t pawn_entry(const std::string &fen) {
+  pawn_entry_t entry;
+  evaluate_pawns(Board(fen), entry);
+  return entry;
+}
+
+inline int test_pawns() {
+  { /* The pawn key follows pawn moves and captures only */
+    Board board("4k3/3p4/8/8/8/8/4P3/4K1N1 w - - 0 1");
+    const hash_t start = board.pawn_hash();
+    board.make_move(quiet_move(G1, F3));
+    ASSERT(board.pawn_hash() == start);
+    board.make_move(double_move(D7, D5));
+    ASSERT(board.pawn_hash() != start);
+    board.unmake_move();
+    board.unmake_move();
+    ASSERT(board.pawn_hash() == start);
+    ASSERT(Board().pawn_hash() == Board("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/4K3 w kq - 0 1").pawn_hash());
+  }
+
+  { /* Structure terms */
+    ASSERT(pawn_entry("4k3/8/8/8/8/8/PPPPPPPP/4K3 w - - 0 1").passed[WHITE] == 0xFF);
+    ASSERT(pawn_entry("4k3/pppppppp/8/8/8/8/PPPPPPPP/4K3 w - - 0 1").passed[WHITE] == 0);
+    // The a- and b-pawns stop each other, and nothing stops the e-pawns
+    const std::string passers = "4k3/1p5p/8/8/4P3/8/P7/4K3 w - - 0 1";
+    ASSERT(pawn_entry(passers).passed[WHITE] == (1u << 4));
+    ASSERT(pawn_entry(passers).passed[BLACK] == (1u << 7));
+    // Doubled, isolated pawns score worse than the same pawns side by side
+    const std::string doubled = "4k3/8/8/8/8/3P4/3P4/4K3 w - - 0 1";
+    const std::string connected = "4k3/8/8/8/8/8/3PP3/4K3 w - - 0 1";
+    ASSERT(pawn_entry(doubled).score.mg < pawn_entry(connected).score.mg);
+    ASSERT(pawn_entry(doubled).score.eg < pawn_entry(connected).score.eg);
+    // A castled king behind its pawns is safer than one on an open file
+    const std::string castled = "4k3/8/8/8/8/8/5PPP/6K1 w - - 0 1";
+    ASSERT(pawn_entry(castled).shield[WHITE][6] > pawn_entry(castled).shield[WHITE][2]);
+  }
+
+  { /* Table hits return the stored entry */
+    PawnTable table(1000);
+    const Board board("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+    const pawn_entry_t &entry = table.probe(board);
+    ASSERT(entry.key == board.pawn_hash() && table.hits() == 0);
+    ASSERT(&table.probe(board) == &entry && table.hits() == 1);
+    ASSERT(evaluate(board, &table) == evaluate(board));
+    // A board without pawns hits the preset entry
+    table.probe(Board("4k3/8/8/8/8/8/8/4K3 w - - 0 1"));
+    ASSERT(table.hits() == 3 && table.probes() == 4);
+  }
+  return 0;
+}
+
+#endif /* end of include guard: TEST_PAWNS_H */
@@ -11,6 +11,7 @@
 #include <map>
 #include <utility>
 #include "timeit.hpp"
+#include "trace.hpp"
 
 struct perft_t {
   std::string fen;
@@ -101,6 +102,7 @@ bool test_perft(const std::string &file_name, int max_depth = 5) {
       std::tie(depth, expect_num) = test;
       if (depth > max_depth) continue;
       const auto diff = timeit([&]{
+        TRACE_SCOPE(PHASE, "perft", depth);
         const size_t actual_num = do_perft(board, depth);
         if (actual_num != expect_num) {
           do_perft_div(board, depth);
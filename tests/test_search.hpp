@@ -0,0 +1,160 @@
+
+#ifndef TEST_SEARCH_H
+#define TEST_SEARCH_H
+
+#include <string>
+
+#include "assert.hpp"
+#include "board.hpp"
+#include "eval.hpp"
+#include "move.hpp"
+#include "search.hpp"
+#include "tt.hpp"
+
+inline int test_search_mate(const std::string &fen, const int depth,
+  const unsigned threads, const int mate_plies, const move_t best_move) {
+  TranspositionTable tt(1, false);
+  Searcher searcher(tt);
+  searcher.set_threads(threads);
+  search_limits_t limits;
+  limits.depth = depth;
+  const search_info_t result = searcher.run(Board(fen), limits);
+  ASSERT_MSG(result.score == mate_in(mate_plies),
+    "Expected mate in %d plies for %s, got score %d", mate_plies, fen.c_str(), result.score);
+  ASSERT_MSG(best_move == NULL_MOVE || result.best_move() == best_move, "Unexpected best move %s for %s",
+    string_from_move(result.best_move()).c_str(), fen.c_str());
+  ASSERT(searcher.nodes() == result.nodes);
+  return 0;
+}
+
+inline int test_search() {
+  int fail_flag = 0;
+  const std::string back_rank = "6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1";
+  const std::string rook_mate = "7k/8/5K2/8/8/8/8/R7 w - - 0 1";
+  for (const unsigned threads : {1u, 3u}) {
+    fail_flag |= test_search_mate(back_rank, 3, threads, 1, quiet_move(A1, A8));
+    fail_flag |= test_search_mate(rook_mate, 4, threads, 3, NULL_MOVE);
+  }
+
+  { /* Node limits stop the search, and a move is still returned */
+    TranspositionTable tt(1, false);
+    Searcher searcher(tt);
+    search_limits_t limits;
+    limits.nodes = 5000;
+    const search_info_t result = searcher.run(Board(), limits);
+    ASSERT(result.best_move() != NULL_MOVE);
+    ASSERT(result.nodes < 2 * limits.nodes);
+  }
+
+  { /* A stop between arm() and run() is kept, and the next run rearms */
+    TranspositionTable tt(1, false);
+    Searcher searcher(tt);
+    search_limits_t limits;
+    limits.depth = 20;
+    searcher.arm(limits);
+    searcher.stop();
+    ASSERT(searcher.run(Board(), limits).depth <= 1);
+    limits.depth = 2;
+    ASSERT(searcher.run(Board(), limits).depth == 2);
+  }
+
+  { /* Thread state carries over between searches and thread counts */
+    TranspositionTable tt(1, false);
+    Searcher searcher(tt);
+    search_limits_t limits;
+    limits.depth = 3;
+    for (const unsigned threads : {1u, 3u, 3u, 1u}) {
+      searcher.set_threads(threads);
+      ASSERT(searcher.threads() == threads);
+      const search_info_t result = searcher.run(Board(back_rank), limits);
+      ASSERT(result.best_move() == quiet_move(A1, A8) && result.nodes == searcher.nodes());
+    }
+    searcher.clear();
+    ASSERT(searcher.run(Board(back_rank), limits).score == mate_in(1));
+  }
+
+  { /* Quiescence search sees the recapture behind a hanging-looking pawn */
+    TranspositionTable tt(1, false);
+    Searcher searcher(tt);
+    search_limits_t limits;
+    limits.depth = 1;
+    Board board("4k3/8/2p5/3p4/8/8/3Q4/4K3 w - - 0 1");
+    const search_info_t result = searcher.run(board, limits);
+    const move_t queen_takes = capture_move(D2, D5);
+    ASSERT(result.best_move() != queen_takes);
+    board.make_move(queen_takes);
+    ASSERT(result.score < -evaluate(board));
+  }
+
+  { /* Search parameters are settable by name */
+    search_params_t params;
+    int value = 0;
+    ASSERT(params.set("futility_margin", 123) && params.futility_margin == 123);
+    ASSERT(params.get("futility_margin", value) && value == 123);
+    ASSERT(!params.set("no_such_param", 1) && !params.get("no_such_param", value));
+    // Defaults lie in the advertised range, and values outside it are clamped
+    for (const std::string &name : search_params_t::names()) {
+      int min = 0, max = 0;
+      ASSERT(params.get(name, value) && search_params_t::range(name, min, max));
+      ASSERT(min <= value && value <= max);
+    }
+    ASSERT(params.set("lmr_divisor", 0) && params.lmr_divisor == 1);
+    ASSERT(params.set("nmp_min_depth", 100000) && params.nmp_min_depth == MAX_PLY + 1);
+  }
+
+  { /* Pruning and reductions shrink the tree without missing the mate */
+    const std::string fen = "r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4";
+    const move_t scholars_mate = capture_move(H5, F7);
+    const std::string kiwipete = "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1";
+    // Only read by the ASSERT, which release builds compile out
+    [[maybe_unused]] size_t nodes[2];
+    for (const bool selective : {true, false}) {
+      TranspositionTable tt(1, false);
+      Searcher searcher(tt);
+      if (!selective) {
+        for (const char *name : {"nmp_min_depth", "lmr_min_depth"})
+          searcher.params().set(name, MAX_PLY + 1);
+        for (const char *name : {"rfp_max_depth", "futility_max_depth", "razor_max_depth", "lmp_max_depth"})
+          searcher.params().set(name, 0);
+      }
+      search_limits_t limits;
+      limits.depth = 5;
+      const search_info_t result = searcher.run(Board(fen), limits);
+      ASSERT(result.best_move() == scholars_mate && result.score == mate_in(1));
+      tt.clear();
+      nodes[selective] = searcher.run(Board(kiwipete), limits).nodes;
+    }
+    ASSERT(nodes[true] < nodes[false]);
+  }
+
+  { /* Multi-PV searches distinct root moves, best first */
+    TranspositionTable tt(1, false);
+    Searcher searcher(tt);
+    search_limits_t limits;
+    limits.depth = 3;
+    limits.multi_pv = 3;
+    const search_info_t result = searcher.run(Board(back_rank), limits);
+    ASSERT(result.lines.size() == 3);
+    ASSERT(result.lines[0].score == mate_in(1) && result.lines[0].pv == result.pv);
+    ASSERT(result.lines[1].score < result.lines[0].score);
+    ASSERT(result.lines[2].score <= result.lines[1].score);
+    ASSERT(result.lines[1].pv[0] != result.lines[0].pv[0] && result.lines[2].pv[0] != result.lines[0].pv[0]
+      && result.lines[2].pv[0] != result.lines[1].pv[0]);
+    // No more lines than legal moves
+    limits.multi_pv = 10;
+    ASSERT(searcher.run(Board("7k/8/8/8/8/8/8/K7 w - - 0 1"), limits).lines.size() == 3);
+  }
+
+  { /* No legal moves at the root */
+    TranspositionTable tt(1, false);
+    Searcher searcher(tt);
+    search_limits_t limits;
+    limits.depth = 2;
+    const search_info_t result = searcher.run(Board("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1"), limits);
+    ASSERT(result.best_move() == NULL_MOVE);
+    ASSERT(result.score == DRAW_SCORE);
+  }
+  return fail_flag;
+}
+
+#endif /* end of include guard: TEST_SEARCH_H */
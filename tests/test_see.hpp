@@ -0,0 +1,53 @@
+
+#ifndef TEST_SEE_H
+#define TEST_SEE_H
+
+#include <string>
+
+#include "assert.hpp"
+#include "board.hpp"
+#include "eval.hpp"
+#include "move.hpp"
+
+inline int test_see_move(const std::string &fen, const move_t move, const int expected) {
+  const Board board(fen);
+  const std::string before = board.fen();
+  ASSERT_MSG(board.see(move) == expected, "SEE of %s in %s: expected %d, got %d",
+    string_from_move(move).c_str(), fen.c_str(), expected, board.see(move));
+  ASSERT(board.see_ge(move, expected));
+  ASSERT(!board.see_ge(move, expected + 1));
+  ASSERT(board.see_ge(move, expected - 1));
+  ASSERT_MSG(board.fen() == before, "SEE modified the board");
+  return 0;
+}
+
+inline int test_see() {
+  int fail_flag = 0;
+  const int P = piece_value[WHITE_PAWN], N = piece_value[WHITE_KNIGHT],
+            B = piece_value[WHITE_BISHOP], R = piece_value[WHITE_ROOK];
+
+  // Undefended pawn
+  fail_flag |= test_see_move("1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1",
+    capture_move(E1, E5), P);
+  // Long sequence, with x-rays behind the rook on e2 and the bishop on f6
+  fail_flag |= test_see_move("1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1",
+    capture_move(D3, E5), P - N);
+  // Defended pawn, the rook is lost
+  fail_flag |= test_see_move("4k3/8/3p4/4p3/8/8/8/4RK2 w - - 0 1",
+    capture_move(E1, E5), P - R);
+  // Doubled rooks win the pawn, the black rook on e8 runs out of recaptures
+  fail_flag |= test_see_move("4r1k1/8/8/4p3/8/8/4R3/4RK2 w - - 0 1",
+    capture_move(E2, E5), P);
+  // Quiet move onto a square guarded by a pawn
+  fail_flag |= test_see_move("4k3/8/3p4/8/8/2B5/8/4K3 w - - 0 1",
+    quiet_move(C3, E5), -B);
+  // The king cannot recapture on a defended square
+  fail_flag |= test_see_move("8/8/8/3k4/4p3/5b2/4R3/4K3 w - - 0 1",
+    capture_move(E2, E4), P - R);
+  // En passant
+  fail_flag |= test_see_move("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1",
+    en_passant_move(E5, D6), P);
+  return fail_flag;
+}
+
+#endif /* end of include guard: TEST_SEE_H */
@@ -0,0 +1,38 @@
+
+#ifndef TEST_STATS_H
+#define TEST_STATS_H
+
+#include "assert.hpp"
+#include "board.hpp"
+#include "search.hpp"
+#include "stats.hpp"
+#include "tt.hpp"
+
+inline int test_stats() {
+  int fail_flag = 0;
+  stats::reset();
+  TranspositionTable tt(1, false);
+  Searcher searcher(tt);
+  searcher.set_threads(2);
+  search_limits_t limits;
+  limits.depth = 4;
+  searcher.run(Board(), limits);
+  const stats_t stats = stats::total();
+#ifdef STATS
+  // Helper threads have exited and folded in their counts
+  fail_flag |= stats.counts[STAT_NODES] == 0 || stats.counts[STAT_QNODES] == 0;
+  // Nodes cut short by the stop are visited but not counted
+  ASSERT(stats.counts[STAT_NODES] + stats.counts[STAT_QNODES] <= searcher.nodes());
+  ASSERT(stats.counts[STAT_TT_HITS] <= stats.counts[STAT_TT_PROBES]);
+  ASSERT(stats.counts[STAT_TT_CUTOFFS] <= stats.counts[STAT_TT_HITS]);
+  ASSERT(stats.counts[STAT_FAIL_HIGHS_FIRST] <= stats.counts[STAT_FAIL_HIGHS]);
+  ASSERT(stats.counts[STAT_MAKE_MOVES] == stats.counts[STAT_UNMAKE_MOVES]);
+  ASSERT(stats.histograms[HIST_MOVES][20] > 0);
+#else
+  // Nothing is counted when compiled out
+  fail_flag |= stats.counts[STAT_NODES] != 0 || stats.counts[STAT_MAKE_MOVES] != 0;
+#endif
+  return fail_flag;
+}
+
+#endif /* end of include guard: TEST_STATS_H */
@@ -0,0 +1,92 @@
+
+#ifndef TEST_TACTICAL_H
+#define TEST_TACTICAL_H
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "assert.hpp"
+#include "board.hpp"
+#include "move.hpp"
+#include "test_board.hpp"
+
+// Quiet moves that leave the opponent in check
+inline std::vector<move_t> checking_moves(Board &board) {
+  std::vector<move_t> result;
+  for (const move_t move : board.generate_moves()) {
+    if (!move_captured(move) && !move_promoted(move) && !move_castled(move)) {
+      if (board.make_move(move) && board.king_in_check())
+        result.push_back(move);
+      board.unmake_move();
+    }
+  }
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+inline int test_tactical_position(Board &board, const int depth) {
+  std::vector<move_t> expected;
+  for (const move_t move : board.generate_moves())
+    if (move_captured(move) || move_promoted(move))
+      expected.push_back(move);
+  std::sort(expected.begin(), expected.end());
+  std::vector<move_t> tactical = board.tactical_moves();
+  std::sort(tactical.begin(), tactical.end());
+  ASSERT_MSG(tactical == expected, "Tactical moves of %s: expected %zu, got %zu",
+    board.fen().c_str(), expected.size(), tactical.size());
+
+  // With checks, the extra legal moves all give check
+  std::vector<move_t> with_checks = board.tactical_moves(true), checks;
+  std::sort(with_checks.begin(), with_checks.end());
+  std::set_difference(with_checks.begin(), with_checks.end(),
+    expected.begin(), expected.end(), std::back_inserter(checks));
+  ASSERT(with_checks.size() == expected.size() + checks.size());
+  for (const move_t move : checks) {
+    ASSERT(!move_captured(move) && !move_promoted(move));
+    if (board.make_move(move))
+      ASSERT_MSG(board.king_in_check(), "Non-checking move %s from tactical_moves in %s",
+        string_from_move(move).c_str(), board.fen().c_str());
+    board.unmake_move();
+  }
+
+  if (depth > 1) {
+    for (const move_t move : board.generate_moves()) {
+      if (board.make_move(move))
+        test_tactical_position(board, depth - 1);
+      board.unmake_move();
+    }
+  }
+  return 0;
+}
+
+inline int test_tactical() {
+  int fail_flag = 0;
+  for (const auto &fen : testFENs) {
+    Board board(fen);
+    fail_flag |= test_tactical_position(board, 2);
+  }
+  // The square past h8 is INVALID_SQUARE, which is not an en passant square
+  for (const std::string fen : {"4k3/7P/8/8/8/8/7p/4K3 w - - 0 1", "k6r/6PP/8/8/8/8/8/4K3 w - - 0 1"}) {
+    Board board(fen);
+    fail_flag |= test_tactical_position(board, 2);
+  }
+
+  // Discovered checks are not generated, but without them every quiet check is
+  for (const std::string fen : {
+    "4k3/8/8/8/8/8/2P5/R3K1NQ w - - 0 1",
+    "4k3/7r/b7/4n3/8/2p5/8/4K3 b - - 0 1",
+    "8/8/3k4/8/1P6/8/4K3/8 w - - 0 1",
+  }) {
+    Board board(fen);
+    std::vector<move_t> checks;
+    for (const move_t move : board.tactical_moves(true))
+      if (!move_captured(move) && !move_promoted(move))
+        checks.push_back(move);
+    std::sort(checks.begin(), checks.end());
+    ASSERT_MSG(checks == checking_moves(board), "Missing checks in %s", fen.c_str());
+  }
+  return fail_flag;
+}
+
+#endif /* end of include guard: TEST_TACTICAL_H */
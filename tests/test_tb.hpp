@@ -0,0 +1,97 @@
+
+#ifndef TEST_TB_H
+#define TEST_TB_H
+
+#include <cstdio>
+#include <filesystem>
+#include <string>
+
+#include "assert.hpp"
+#include "board.hpp"
+#include "move.hpp"
+#include "simulate.hpp"
+#include "tb.hpp"
+
+// Whether board's table entry agrees with those of its successors
+inline bool tb_consistent(Board &board) {
+  tb::probe_result_t result;
+  if (!tb::probe(board, result))
+    return false;
+  bool found_best = false, all_lose = true;
+  for (const move_t move : board.legal_moves()) {
+    board.make_move(move);
+    tb::probe_result_t child;
+    const bool covered = tb::probe(board, child);
+    board.unmake_move();
+    if (!covered)
+      return false;
+    // The best move mates one ply sooner than the reply; nothing mates faster
+    if (result.wdl == tb::TB_WIN && child.wdl == tb::TB_LOSS && child.dtm < result.dtm - 1)
+      return false;
+    found_best |= (result.wdl == tb::TB_WIN) ? child.wdl == tb::TB_LOSS && child.dtm == result.dtm - 1
+      : (result.wdl == tb::TB_LOSS) ? child.wdl == tb::TB_WIN && child.dtm == result.dtm - 1
+      : child.wdl == tb::TB_DRAW;
+    all_lose &= child.wdl == tb::TB_WIN && child.dtm < result.dtm;
+  }
+  return found_best && (result.wdl != tb::TB_LOSS || all_lose);
+}
+
+inline int test_tb() {
+  const std::string dir = (std::filesystem::temp_directory_path() / "playchess_test_tb").string();
+  std::filesystem::create_directories(dir);
+  ASSERT(tb::valid_name("KRvK") && !tb::valid_name("KvKR") && !tb::valid_name("KPvK"));
+  ASSERT(!tb::generate("KvKR", dir) && !tb::generate("KPvK", dir));
+  ASSERT(Board("7k/8/5K2/8/8/8/8/R7 w - - 0 1").m_castle_state == 0);
+  ASSERT(tb::table_name(Board("8/8/8/3k4/8/8/8/2r1K3 w - - 0 1")) == "KRvK");
+  // KRvK, and KQvK on two threads
+  const bool generated = tb::generate("KRvK", dir) && tb::generate("KQvK", dir, 2);
+  ASSERT(generated);
+  const size_t loaded = tb::init(dir);
+  ASSERT(loaded == 2 && tb::max_pieces() == 3);
+
+  { /* Known results, with either colour stronger */
+    tb::probe_result_t result;
+    ASSERT(tb::probe(Board("7k/8/5K2/8/8/8/8/R7 w - - 0 1"), result));
+    ASSERT(result.wdl == tb::TB_WIN && result.dtm == 3);
+    ASSERT(tb::probe(Board("R6k/8/6K1/8/8/8/8/8 b - - 0 1"), result));
+    ASSERT(result.wdl == tb::TB_LOSS && result.dtm == 0);
+    ASSERT(tb::probe(Board("8/8/8/8/8/6k1/8/r6K w - - 0 1"), result));
+    ASSERT(result.wdl == tb::TB_LOSS && result.dtm == 0);
+    // Stalemate, and the rook falling
+    ASSERT(tb::probe(Board("7k/5Q2/6K1/8/8/8/8/8 b - - 0 1"), result));
+    ASSERT(result.wdl == tb::TB_DRAW);
+    ASSERT(tb::probe(Board("8/8/8/8/8/8/6kR/K7 b - - 0 1"), result));
+    ASSERT(result.wdl == tb::TB_DRAW);
+    // The longest rook mate is 16 moves
+    ASSERT(tb::probe(Board("8/8/8/3k4/8/8/8/R3K3 w - - 0 1"), result));
+    ASSERT(result.wdl == tb::TB_WIN && result.dtm <= 31);
+    // Castling rights and missing tables are not covered
+    ASSERT(!tb::probe(Board("4k3/8/8/8/8/8/8/R3K3 w Q - 0 1"), result));
+    ASSERT(!tb::probe(Board("4k3/8/8/8/8/8/8/RR2K3 w - - 0 1"), result));
+    // Nor are mates the fifty move rule would come first for
+    ASSERT(tb::probe(Board("7k/8/5K2/8/8/8/8/R7 w - - 72 80"), result) && result.dtm == 3);
+    ASSERT(!tb::probe(Board("7k/8/5K2/8/8/8/8/R7 w - - 73 80"), result));
+    ASSERT(tb::probe(Board("7k/5Q2/6K1/8/8/8/8/8 b - - 75 80"), result) && result.wdl == tb::TB_DRAW);
+  }
+
+  { /* Entries agree with their successors */
+    for (const std::string fen : {"8/8/8/3k4/8/8/8/R3K3 w - - 0 1", "8/8/8/3k4/8/8/8/R3K3 b - - 0 1",
+        "8/2k5/8/8/4Q3/8/8/7K w - - 0 1", "8/2k5/8/8/4Q3/8/8/7K b - - 0 1",
+        "1q6/8/8/8/8/3k4/8/4K3 b - - 0 1"}) {
+      Board board(fen);
+      ASSERT(tb_consistent(board));
+    }
+  }
+
+  { /* Playouts stop in the tables */
+    const game_record record = simulate_random("8/8/8/3k4/8/8/8/2r1K3 w - - 0 1");
+    ASSERT(record.moves.empty() && record.result == -1);
+  }
+
+  tb::release();
+  ASSERT(tb::max_pieces() == 0);
+  std::filesystem::remove_all(dir);
+  return 0;
+}
+
+#endif /* end of include guard: TEST_TB_H */
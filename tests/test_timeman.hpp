@@ -0,0 +1,70 @@
+
+#ifndef TEST_TIMEMAN_H
+#define TEST_TIMEMAN_H
+
+#include <chrono>
+#include <string>
+
+#include "assert.hpp"
+#include "board.hpp"
+#include "search.hpp"
+#include "simulate.hpp"
+#include "strategies/random_strat.hpp"
+#include "strategies/search_strat.hpp"
+#include "timeman.hpp"
+#include "tt.hpp"
+
+inline int test_timeman() {
+  int fail_flag = 0;
+
+  { /* Allocation stays within the clock */
+    ASSERT(allocate_time(time_control_t()).hard_ms == 0);
+    const size_t share = (60000 - MOVE_OVERHEAD_MS) / DEFAULT_MOVES_TO_GO;
+    ASSERT(allocate_time({60000, 0, 0}).soft_ms == share);
+    ASSERT(allocate_time({60000, 0, 0}).hard_ms == share * HARD_LIMIT_RATIO);
+    // The increment is mostly spent, but never more than is on the clock
+    ASSERT(allocate_time({60000, 1000, 0}).soft_ms > share);
+    ASSERT(allocate_time({100, 5000, 0}).soft_ms <= allocate_time({100, 5000, 0}).hard_ms);
+    ASSERT(allocate_time({100, 5000, 0}).hard_ms < 100);
+    // The last move before the time control may use nearly everything
+    ASSERT(allocate_time({1000, 0, 1}).hard_ms == 1000 - MOVE_OVERHEAD_MS);
+  }
+
+  { /* The soft deadline stretches on instability and score drops */
+    const move_t first = quiet_move(E2, E4), second = quiet_move(D2, D4);
+    TimeManager stable, unstable;
+    stable.start({1000, 4000});
+    unstable.start({1000, 4000});
+    for (int iteration = 0; iteration < 6; ++iteration) {
+      stable.should_continue(first, 20, 0);
+      unstable.should_continue((iteration & 1) ? first : second, 20 - 50 * iteration, 0);
+    }
+    ASSERT(stable.soft_ms() < 1000);
+    ASSERT(unstable.soft_ms() > 1000 && unstable.soft_ms() <= 4000);
+    ASSERT(!stable.should_continue(first, 20, 1000));
+  }
+
+  { /* A clocked search returns well within its hard deadline */
+    TranspositionTable tt(1, false);
+    Searcher searcher(tt);
+    search_limits_t limits;
+    limits.clock = {2000, 0, 0};
+    const auto start = std::chrono::steady_clock::now();
+    const search_info_t result = searcher.run(Board(), limits);
+    const auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start).count();
+    ASSERT(result.best_move() != NULL_MOVE);
+    ASSERT((size_t)elapsed_ms < allocate_time(limits.clock).hard_ms + 100);
+  }
+
+  { /* Timed games charge each side for its moves */
+    const time_control_t clock = {2000, 10, 0};
+    const game_record record = simulate_game(SearchStrategy(search_limits_t(), 1), RandomStrategy(),
+      "7k/8/5K2/8/8/8/8/R7 w - - 0 1", clock);
+    ASSERT(!record.time_forfeit && record.result == 1);
+    ASSERT(record.moves.size() <= 5);
+  }
+  return fail_flag;
+}
+
+#endif /* end of include guard: TEST_TIMEMAN_H */
@@ -0,0 +1,51 @@
+
+#ifndef TEST_TRACE_H
+#define TEST_TRACE_H
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "assert.hpp"
+#include "board.hpp"
+#include "trace.hpp"
+
+inline int test_trace() {
+  int fail_flag = 0;
+
+  { /* Events from every thread are dumped as Chrome trace events */
+    trace::clear();
+    {
+      TRACE_SCOPE_ENABLED("outer", 1);
+      TRACE_EVENT_ENABLED("instant", 2);
+    }
+    std::thread([] { TRACE_SCOPE_ENABLED("helper", 3); }).join();
+    ASSERT(trace::num_events() == 3);
+    std::ostringstream out;
+    trace::dump_chrome(out);
+    const std::string json = out.str();
+    ASSERT(json.rfind("{\"traceEvents\":[", 0) == 0);
+    ASSERT(json.find("\"name\":\"outer\",\"pid\":1,\"tid\":") != std::string::npos);
+    ASSERT(json.find("\"ph\":\"i\",\"s\":\"t\",\"args\":{\"arg\":2}") != std::string::npos);
+    ASSERT(json.find("\"name\":\"helper\"") != std::string::npos);
+  }
+
+  { /* The ring buffer keeps the newest events */
+    trace::clear();
+    for (int idx = 0; idx < trace::BUFFER_SIZE + 10; ++idx)
+      TRACE_EVENT_ENABLED("event", idx);
+    ASSERT(trace::num_events() == trace::BUFFER_SIZE);
+    trace::clear();
+  }
+
+  { /* Levels above TRACE_LEVEL are compiled out */
+    Board board;
+    board.make_move(board.pseudo_moves()[0]);
+    board.unmake_move();
+    ASSERT(trace::num_events() == (TRACE_LEVEL >= 2 ? 2 : 0));
+    trace::clear();
+  }
+  return fail_flag;
+}
+
+#endif /* end of include guard: TEST_TRACE_H */
@@ -0,0 +1,70 @@
+
+#ifndef TEST_TT_H
+#define TEST_TT_H
+
+#include "assert.hpp"
+#include "board.hpp"
+#include "move.hpp"
+#include "tt.hpp"
+
+inline int test_tt() {
+  TranspositionTable tt(1, false);
+  const Board board;
+  const hash_t hash = board.hash();
+  const move_t move = double_move(E2, E4);
+
+  { /* Empty table misses */
+    bool found = true;
+    const tt_entry_t *entry = tt.probe(hash, found);
+    ASSERT(!found);
+    ASSERT(entry->empty());
+  }
+
+  { /* Stored entries are found again */
+    bool found = false;
+    tt.probe(hash, found)->save(hash, 25, 10, move, 6, BOUND_EXACT, tt.generation());
+    const tt_entry_t *entry = tt.probe(hash, found);
+    ASSERT(found);
+    ASSERT(entry->move() == move);
+    ASSERT(entry->score() == 25);
+    ASSERT(entry->eval() == 10);
+    ASSERT(entry->depth() == 6);
+    ASSERT(entry->bound() == BOUND_EXACT);
+  }
+
+  { /* Shallower non-exact results do not overwrite, and keep the move */
+    bool found = false;
+    tt.probe(hash, found)->save(hash, -40, 10, NULL_MOVE, 1, BOUND_UPPER, tt.generation());
+    const tt_entry_t *entry = tt.probe(hash, found);
+    ASSERT(found);
+    ASSERT(entry->depth() == 6);
+    ASSERT(entry->move() == move);
+  }
+
+  { /* Replacement prefers shallow entries, then old ones */
+    hash_t keys[TT_CLUSTER_SIZE + 1];
+    for (unsigned idx = 0; idx <= TT_CLUSTER_SIZE; ++idx)
+      keys[idx] = (hash & ~0xFFFFull) | idx; // Same cluster, distinct keys
+    const int depths[TT_CLUSTER_SIZE] = {12, 10, 8, 14, 16, 18};
+    bool found = false;
+    tt.clear(2);
+    for (unsigned idx = 0; idx < TT_CLUSTER_SIZE; ++idx)
+      tt.probe(keys[idx], found)->save(keys[idx], 0, 0, move, depths[idx], BOUND_LOWER, tt.generation());
+    ASSERT(tt.probe(keys[TT_CLUSTER_SIZE], found)->depth() == 8);
+    ASSERT(!found);
+
+    tt.clear(2);
+    tt.probe(keys[0], found)->save(keys[0], 0, 0, move, 12, BOUND_LOWER, tt.generation());
+    tt.new_search();
+    for (unsigned idx = 1; idx < TT_CLUSTER_SIZE; ++idx)
+      tt.probe(keys[idx], found)->save(keys[idx], 0, 0, move, 10, BOUND_LOWER, tt.generation());
+    ASSERT(tt.probe(keys[TT_CLUSTER_SIZE], found)->depth() == 12);
+    ASSERT(!found);
+  }
+
+  tt.clear();
+  ASSERT(tt.hashfull() == 0);
+  return 0;
+}
+
+#endif /* end of include guard: TEST_TT_H */
@@ -0,0 +1,78 @@
+
+#ifndef TEST_UCI_H
+#define TEST_UCI_H
+
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "assert.hpp"
+#include "board.hpp"
+#include "uci.hpp"
+
+inline size_t count_lines(const std::string &output, const std::string &prefix) {
+  std::istringstream lines(output);
+  size_t result = 0;
+  for (std::string line; std::getline(lines, line);)
+    result += line.rfind(prefix, 0) == 0;
+  return result;
+}
+
+inline int test_uci() {
+  int fail_flag = 0;
+  { /* Handshake, positions and fixed-depth searches */
+    std::ostringstream out;
+    uci::Engine engine(out);
+    engine.handle("uci");
+    engine.handle("isready");
+    ASSERT(count_lines(out.str(), "uciok") == 1 && count_lines(out.str(), "readyok") == 1);
+    engine.handle("position startpos moves e2e4 e7e5 g1f3");
+    ASSERT(engine.position().fen() == "rnbqkbnr/pppp1ppp/8/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R b KQkq - 1 2");
+    // Captures and promotions in coordinate notation
+    engine.handle("position fen 4k3/1P6/8/3p4/4P3/8/8/4K3 w - - 0 1 moves e4d5 e8f7 b7b8q");
+    ASSERT(engine.position().fen() == "1Q6/5k2/8/3P4/8/8/8/4K3 b - - 0 2");
+    engine.handle("position fen 6k1/5ppp/8/8/8/8/5PPP/R5K1 w - - 0 1");
+    engine.handle("setoption name Threads value 2");
+    engine.handle("go depth 3");
+    engine.wait();
+    ASSERT(count_lines(out.str(), "bestmove a1a8") == 1);
+    ASSERT(out.str().find("score mate 1") != std::string::npos);
+  }
+
+  { /* Infinite and ponder searches report only after stop or ponderhit */
+    std::ostringstream out;
+    uci::Engine engine(out);
+    engine.handle("position startpos");
+    engine.handle("go infinite");
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    // The search is still writing info lines, so out is only read under the
+    // engine's output lock until wait() returns
+    const auto running_output = [&] {
+      const std::unique_lock<std::mutex> lock = engine.lock_output();
+      return out.str();
+    };
+    fail_flag |= count_lines(running_output(), "bestmove") != 0;
+    engine.handle("stop");
+    engine.wait();
+    ASSERT(count_lines(out.str(), "bestmove") == 1);
+
+    engine.handle("go ponder movetime 10");
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    fail_flag |= count_lines(running_output(), "bestmove") != 1;
+    engine.handle("ponderhit");
+    engine.wait();
+    ASSERT(count_lines(out.str(), "bestmove") == 2);
+  }
+
+  { /* The loop reads its input on another thread, and ends with it */
+    std::istringstream in("uci\nposition startpos moves d2d4\ngo nodes 500\n");
+    std::ostringstream out;
+    ASSERT(uci::loop(in, out) == 0);
+    ASSERT(count_lines(out.str(), "uciok") == 1 && count_lines(out.str(), "bestmove") == 1);
+  }
+  return fail_flag;
+}
+
+#endif /* end of include guard: TEST_UCI_H */